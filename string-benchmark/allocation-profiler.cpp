@@ -0,0 +1,359 @@
+/**
+ * Allocation profiler.
+ *
+ * Interposes the C allocator, operator new/delete, the Boehm GC allocator
+ * and Python's object allocator, either preloaded:
+ *
+ *     $ LD_PRELOAD=./liballocation-profiler.so ./cat-std-string DATA
+ *
+ * or linked into every benchmark (cmake -DPROFILE_ALLOCATIONS=ON).
+ *
+ * At exit, one JSON line goes to stderr or to the file named by the
+ * BENCHMARK_ALLOCATIONS environment variable, with per allocator family:
+ * allocation, free and realloc counts, bytes requested, peak live bytes
+ * (when the size of a freed block is known) and a histogram of request
+ * sizes by power of two. Perl allocates with malloc(), it is counted there.
+ */
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <dlfcn.h>
+#include <malloc.h>
+#include <unistd.h>
+
+extern "C"
+{
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void  __libc_free(void*);
+}
+
+namespace
+{
+
+const int size_classes = 65; // one per power of two of a size_t
+
+struct family
+{
+    const char* name;
+    bool sized; // free knows the size of the block, so live bytes are tracked.
+    unsigned long allocations;
+    unsigned long frees;
+    unsigned long reallocs;
+    unsigned long bytes;
+    long live;
+    long peak;
+    unsigned long histogram[size_classes];
+};
+
+family malloc_family = { "malloc", true, 0, 0, 0, 0, 0, 0, {} };
+family gc_family     = { "gc", false, 0, 0, 0, 0, 0, 0, {} };
+family python_family = { "python", false, 0, 0, 0, 0, 0, 0, {} };
+
+unsigned long news;    // operator new calls, also counted as malloc
+unsigned long deletes; // operator delete calls, also counted as free
+
+inline int size_class(size_t size)
+{
+    return size ? 64 - __builtin_clzl(size) : 0;
+}
+
+inline void grow(family& f, long delta)
+{
+    const long live = __atomic_add_fetch(&f.live, delta, __ATOMIC_RELAXED);
+    long peak = __atomic_load_n(&f.peak, __ATOMIC_RELAXED);
+    while (live > peak and not __atomic_compare_exchange_n(&f.peak, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        // peak was reloaded, try again.
+    }
+}
+
+inline void allocated(family& f, size_t requested, long usable)
+{
+    __atomic_add_fetch(&f.allocations, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&f.bytes, requested, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&f.histogram[size_class(requested)], 1, __ATOMIC_RELAXED);
+    if (f.sized)
+    {
+        grow(f, usable);
+    }
+}
+
+inline void freed(family& f, long usable)
+{
+    __atomic_add_fetch(&f.frees, 1, __ATOMIC_RELAXED);
+    if (f.sized)
+    {
+        __atomic_sub_fetch(&f.live, usable, __ATOMIC_RELAXED);
+    }
+}
+
+inline void* tracked(void* block, size_t requested)
+{
+    if (block)
+    {
+        allocated(malloc_family, requested, malloc_usable_size(block));
+    }
+    return block;
+}
+
+/**
+ * Next definition of an interposed function, 0 when the program does not use that library.
+ */
+template<typename F>
+inline F next(const char* const symbol)
+{
+    return reinterpret_cast<F>(dlsym(RTLD_NEXT, symbol));
+}
+
+void print(FILE* report, const family& f)
+{
+    fprintf(report, "\"%s\": {\"allocations\": %lu, \"frees\": %lu, \"reallocs\": %lu, \"bytes\": %lu",
+            f.name, f.allocations, f.frees, f.reallocs, f.bytes);
+    if (f.sized)
+    {
+        fprintf(report, ", \"peak\": %ld", f.peak);
+    }
+    fputs(", \"histogram\": {", report);
+    const char* separator = "";
+    for (int i = 0; i < size_classes; ++i)
+    {
+        if (f.histogram[i])
+        {
+            fprintf(report, "%s\"%lu\": %lu", separator, i ? (1UL << (i - 1)) : 0UL, f.histogram[i]);
+            separator = ", ";
+        }
+    }
+    fputs("}}", report);
+}
+
+__attribute__((destructor)) void report()
+{
+    // Copies, so that stdio allocations below do not show in the report.
+    const family families[] = { malloc_family, gc_family, python_family };
+    const unsigned long new_calls = news, delete_calls = deletes;
+
+    const char* const file_name = getenv("BENCHMARK_ALLOCATIONS");
+    FILE* const report = file_name ? fopen(file_name, "a") : stderr;
+    if (not report)
+    {
+        return;
+    }
+
+    fprintf(report, "{\"event\": \"allocations\", \"new\": %lu, \"delete\": %lu", new_calls, delete_calls);
+    for (size_t i = 0; i < sizeof(families) / sizeof(families[0]); ++i)
+    {
+        fputs(", ", report);
+        print(report, families[i]);
+    }
+    fputs("}\n", report);
+
+    if (report != stderr)
+    {
+        fclose(report);
+    }
+}
+
+} // anonymous namespace
+
+extern "C"
+{
+
+void* malloc(size_t size)
+{
+    return tracked(__libc_malloc(size), size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    return tracked(__libc_calloc(count, size), count * size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return tracked(__libc_memalign(alignment, size), size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+void* valloc(size_t size)
+{
+    return memalign(sysconf(_SC_PAGESIZE), size);
+}
+
+int posix_memalign(void** block, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void*) != 0 or (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    *block = memalign(alignment, size);
+    return *block ? 0 : ENOMEM;
+}
+
+void free(void* block)
+{
+    if (block)
+    {
+        freed(malloc_family, malloc_usable_size(block));
+        __libc_free(block);
+    }
+}
+
+void* realloc(void* block, size_t size)
+{
+    if (not block)
+    {
+        return malloc(size);
+    }
+    const long before = malloc_usable_size(block);
+    void* const result = __libc_realloc(block, size);
+    if (result)
+    {
+        __atomic_add_fetch(&malloc_family.reallocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&malloc_family.bytes, size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&malloc_family.histogram[size_class(size)], 1, __ATOMIC_RELAXED);
+        grow(malloc_family, static_cast<long>(malloc_usable_size(result)) - before);
+    }
+    return result;
+}
+
+/*
+ * Boehm GC, the collector reclaims memory without calling GC_free().
+ */
+void* GC_malloc(size_t size)
+{
+    static void* (*const real)(size_t) = next<void* (*)(size_t)>("GC_malloc");
+    allocated(gc_family, size, 0);
+    return real(size);
+}
+
+void* GC_malloc_atomic(size_t size)
+{
+    static void* (*const real)(size_t) = next<void* (*)(size_t)>("GC_malloc_atomic");
+    allocated(gc_family, size, 0);
+    return real(size);
+}
+
+void* GC_malloc_uncollectable(size_t size)
+{
+    static void* (*const real)(size_t) = next<void* (*)(size_t)>("GC_malloc_uncollectable");
+    allocated(gc_family, size, 0);
+    return real(size);
+}
+
+void* GC_realloc(void* block, size_t size)
+{
+    static void* (*const real)(void*, size_t) = next<void* (*)(void*, size_t)>("GC_realloc");
+    __atomic_add_fetch(&gc_family.reallocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&gc_family.bytes, size, __ATOMIC_RELAXED);
+    return real(block, size);
+}
+
+void GC_free(void* block)
+{
+    static void (*const real)(void*) = next<void (*)(void*)>("GC_free");
+    freed(gc_family, 0);
+    real(block);
+}
+
+/*
+ * Python's small object allocator, hooked only when libpython calls it through the PLT.
+ */
+void* PyObject_Malloc(size_t size)
+{
+    static void* (*const real)(size_t) = next<void* (*)(size_t)>("PyObject_Malloc");
+    allocated(python_family, size, 0);
+    return real(size);
+}
+
+void* PyObject_Realloc(void* block, size_t size)
+{
+    static void* (*const real)(void*, size_t) = next<void* (*)(void*, size_t)>("PyObject_Realloc");
+    __atomic_add_fetch(&python_family.reallocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&python_family.bytes, size, __ATOMIC_RELAXED);
+    return real(block, size);
+}
+
+void PyObject_Free(void* block)
+{
+    static void (*const real)(void*) = next<void (*)(void*)>("PyObject_Free");
+    if (block)
+    {
+        freed(python_family, 0);
+    }
+    real(block);
+}
+
+} // extern "C"
+
+/*
+ * operator new/delete, on top of malloc()/free() above.
+ */
+void* operator new(size_t size)
+{
+    __atomic_add_fetch(&news, 1, __ATOMIC_RELAXED);
+    void* const block = malloc(size ? size : 1);
+    if (not block)
+    {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+    __atomic_add_fetch(&news, 1, __ATOMIC_RELAXED);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) throw()
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* block) throw()
+{
+    if (block)
+    {
+        __atomic_add_fetch(&deletes, 1, __ATOMIC_RELAXED);
+        free(block);
+    }
+}
+
+void operator delete[](void* block) throw()
+{
+    operator delete(block);
+}
+
+void operator delete(void* block, size_t) throw()
+{
+    operator delete(block);
+}
+
+void operator delete[](void* block, size_t) throw()
+{
+    operator delete(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) throw()
+{
+    operator delete(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) throw()
+{
+    operator delete(block);
+}
@@ -0,0 +1,266 @@
+/**
+ * Arena backed strings, for request scoped allocation freed in bulk.
+ *
+ * Every thread allocates from an arena of its own (see lease.hpp):
+ * chunks of at least 1M are carved from the front and
+ * nothing is freed until BENCHMARK_ITERATE rewinds all the arenas before
+ * the next pass, which reuses the chunks, whatever their order: with
+ * --threads an arena may serve another shard than before. The last
+ * allocation of an arena can grow in place, which is what appending to
+ * the newest string does.
+ *
+ * Iteration lines of the timing report carry the bytes allocated during
+ * the pass (the high-water mark, summed over the arenas) and the bytes of
+ * chunks reserved.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "lease.hpp"
+
+#define BENCHMARK_REWIND() benchmark::arena::rewind_all_()
+#define BENCHMARK_EXTRA_FIELDS &benchmark::arena::report_
+
+namespace benchmark
+{
+
+class arena
+{
+public:
+    /**
+     * The arena of the calling thread.
+     */
+    static inline arena& local_()
+    {
+        return leased<arena>::local_();
+    }
+
+    /**
+     * Frees every allocation of every arena, between passes only.
+     */
+    static void rewind_all_()
+    {
+        rewind rewinder;
+        leased<arena>::for_each_(rewinder);
+    }
+
+    /**
+     * Bytes allocated since the last rewind, and bytes reserved, summed over the arenas.
+     */
+    static void usage_all_(unsigned long& high_water, unsigned long& reserved)
+    {
+        usage total = { 0, 0 };
+        leased<arena>::for_each_(total);
+        high_water = total.high_water;
+        reserved = total.reserved;
+    }
+
+    /**
+     * The arena usage fields of a timing report line.
+     */
+    static void report_(FILE* report)
+    {
+        unsigned long high_water, reserved;
+        usage_all_(high_water, reserved);
+        fprintf(report, ", \"arena-high-water\": %lu, \"arena-reserved\": %lu", high_water, reserved);
+    }
+
+    arena() : m_current(0), m_top(0), m_end(0), m_high_water(0), m_reserved(0)
+    {
+    }
+
+    inline char* allocate_(size_t n)
+    {
+        if (static_cast<size_t>(m_end - m_top) < n)
+        {
+            next_(n);
+        }
+        char* const p = m_top;
+        m_top += n;
+        m_high_water += n;
+        return p;
+    }
+
+    /**
+     * Grows p, of old bytes, to n bytes when it is the last allocation and the chunk has room.
+     */
+    inline bool extend_(char* p, size_t old, size_t n)
+    {
+        if (p + old != m_top or static_cast<size_t>(m_end - p) < n)
+        {
+            return false;
+        }
+        m_top = p + n;
+        m_high_water += n - old;
+        return true;
+    }
+
+private:
+    struct chunk
+    {
+        char* begin;
+        size_t length;
+    };
+
+    struct rewind
+    {
+        inline void operator()(arena& a) const
+        {
+            a.rewind_();
+        }
+    };
+
+    struct usage
+    {
+        unsigned long high_water;
+        unsigned long reserved;
+
+        inline void operator()(const arena& a)
+        {
+            high_water += a.m_high_water;
+            reserved += a.m_reserved;
+        }
+    };
+
+    /**
+     * Moves on to an unused chunk that holds n bytes, reserving one when there is none.
+     * Chunks up to m_current are in use, the one found is swapped in after them,
+     * so that the smaller ones skipped remain available.
+     */
+    void next_(size_t n)
+    {
+        static const size_t least = 1 << 20;
+        const size_t next = m_top ? m_current + 1 : 0;
+        size_t fit = next;
+        for (; fit < m_chunks.size() and m_chunks[fit].length < n; ++fit)
+        {
+        }
+        if (fit == m_chunks.size())
+        {
+            chunk fresh = { 0, n > least ? n : least };
+            if ((fresh.begin = static_cast<char*>(malloc(fresh.length))) == 0)
+            {
+                exit(ENOMEM);
+            }
+            m_chunks.push_back(fresh);
+            m_reserved += fresh.length;
+        }
+        std::swap(m_chunks[next], m_chunks[fit]);
+        m_current = next;
+        m_top = m_chunks[next].begin;
+        m_end = m_top + m_chunks[next].length;
+    }
+
+    void rewind_()
+    {
+        m_current = 0;
+        m_top = m_end = 0;
+        m_high_water = 0;
+    }
+
+    std::vector<chunk> m_chunks; // never freed, arenas live as long as the program.
+    size_t m_current;
+    char* m_top;
+    char* m_end;
+    unsigned long m_high_water;
+    unsigned long m_reserved;
+};
+
+} // benchmark namespace
+
+/**
+ * String allocated from the arena of the thread that builds it.
+ * Copies and substrings are new allocations, growth doubles the capacity,
+ * in place when possible.
+ */
+class ArenaString
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    ArenaString() : m_data(0), m_size(0), m_capacity(0)
+    {
+    }
+
+    ArenaString(const char* s, size_t n) : m_data(0), m_size(0), m_capacity(0)
+    {
+        assign(s, n);
+    }
+
+    ArenaString(const ArenaString& other) : m_data(0), m_size(0), m_capacity(0)
+    {
+        assign(other.m_data, other.m_size);
+    }
+
+    inline ArenaString& operator=(const ArenaString& other)
+    {
+        if (this != &other)
+        {
+            assign(other.m_data, other.m_size);
+        }
+        return *this;
+    }
+
+    inline void assign(const char* s, size_t n)
+    {
+        if (n > m_capacity)
+        {
+            m_data = benchmark::arena::local_().allocate_(n);
+            m_capacity = n;
+        }
+        memcpy(m_data, s, n);
+        m_size = n;
+    }
+
+    inline void append(const char* s, size_t n)
+    {
+        if (m_size + n > m_capacity)
+        {
+            grow_(m_size + n);
+        }
+        memcpy(m_data + m_size, s, n);
+        m_size += n;
+    }
+
+    inline bool operator==(const ArenaString& other) const
+    {
+        return m_size == other.m_size and memcmp(m_data, other.m_data, m_size) == 0;
+    }
+
+    inline ArenaString substr(size_t pos, size_t n = npos) const
+    {
+        return ArenaString(m_data + pos, std::min(n, m_size - pos));
+    }
+
+    inline const char* data() const
+    {
+        return m_data;
+    }
+
+    inline size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    void grow_(size_t n)
+    {
+        const size_t capacity = std::max(n, 2 * m_capacity);
+        benchmark::arena& local = benchmark::arena::local_();
+        if (not (m_data and local.extend_(m_data, m_capacity, capacity)))
+        {
+            char* const data = local.allocate_(capacity);
+            memcpy(data, m_data, m_size);
+            m_data = data;
+        }
+        m_capacity = capacity;
+    }
+
+    char* m_data;
+    size_t m_size;
+    size_t m_capacity;
+};
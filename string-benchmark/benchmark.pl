@@ -7,8 +7,10 @@ use Getopt::Long;
 use File::Basename;
 use Tie::IxHash;
 use Data::Dumper;
+use Errno qw(ENOTSUP);
+use JSON::PP;
 
-my @benchmarks = qw(new cat cmp slice);
+my @benchmarks = qw(new cat cmp slice find hash sort split replace case format join intern compare);
 
 my $OS_TIME = '/usr/bin/time';
 my $OS_HASH = '/usr/bin/md5sum';
@@ -23,7 +25,26 @@ my $opt_output          = '/dev/null';
 my $opt_verbose         = 0;
 my $opt_discard = qr/cat-yegorushkin-const-string/ ; # Is quadratic in this context, just as PyStringObject::Concat, skip it.
 my $opt_scheduling = '';
-my $opt_valgrind = 0;
+my $opt_allocations = 0;
+my $opt_threads = '1'; # comma separated thread counts and/or ranges, e.g. 1,2,4 or 1..8
+my @opt_threads;
+my $opt_batch = '';     # comma separated join batch sizes and/or ranges, e.g. 1,4,16,64
+my @opt_batch;
+my $opt_warmup = 0;
+my $opt_in_process = 0; # time in the program itself rather than with time(1)
+my $opt_counters = '';  # perf_event_open events, 'all' or e.g. cycles,instructions
+my $opt_map = '';       # input mapping policies, e.g. populate,hugepage or copy
+my $opt_corpus = '';    # comma separated names of standard corpora, see %corpora
+my $opt_corpus_size = '64M';
+
+## Standard corpora, made by the generate program so that everyone benchmarks the same data.
+my %corpora = (
+    paths      => '--length=zipf:1.1:256 --alphabet=path --duplicates=0.05',
+    sso        => '--length=bimodal:15 --alphabet=alnum',
+    short      => '--length=uniform:1:16 --alphabet=alnum',
+    long       => '--length=uniform:256:4096 --alphabet=alnum',
+    duplicates => '--length=uniform:8:128 --alphabet=path --duplicates=0.5',
+);
 
 my $opt_time_format = # should eval() to a Perl hash when passed through time(1) --format
   q['{ user => %U, real => %e, system => %S, cpu => "%P", text => %X, data => %D, "max-memory" => %M, "average-memory" => %K,] .
@@ -40,7 +61,15 @@ GetOptions(
             'discard=s'         => \$opt_discard,
             'verbose!'          => \$opt_verbose,
             'fifo-scheduling=i' => \$opt_scheduling,
-            'grind!'            => \$opt_valgrind,
+            'allocations|grind!' => \$opt_allocations,
+            'threads=s'         => \$opt_threads,
+            'batch=s'           => \$opt_batch,
+            'warmup=i'          => \$opt_warmup,
+            'in-process!'       => \$opt_in_process,
+            'counters=s'        => \$opt_counters,
+            'map=s'             => \$opt_map,
+            'corpus=s'          => \$opt_corpus,
+            'corpus-size=s'     => \$opt_corpus_size,
             'time=s'            => \$OS_TIME,
             'hash=s'            => \$OS_HASH,
             'chrt=s'            => \$OS_CHRT
@@ -56,6 +85,8 @@ sub main
     $opt_repeats = 1 if $opt_repeats <= 0;
     $opt_iterations = 1 if $opt_iterations <= 0;
     $opt_scheduling = "$OS_CHRT --fifo $opt_scheduling " if length $opt_scheduling;
+    @opt_threads = map { /^(\d+)\.\.(\d+)$/ ? ( $1 .. $2 ) : $_ } split /,/, $opt_threads;
+    @opt_batch = map { /^(\d+)\.\.(\d+)$/ ? ( $1 .. $2 ) : $_ } split /,/, $opt_batch;
 
     my %programs;
     my $count = 0;
@@ -64,22 +95,41 @@ sub main
     {
         $count +=
           @{ $programs{ $benchmark } =
-              [ grep { -x and /$opt_benchmark/o } <$opt_build_directory/$benchmark*> ] };
+              [ grep { -x and /$opt_benchmark/o } <$opt_build_directory/$benchmark-*> ] };
     }
 
     die
       "No program(s) found: run (c)make first or specify a build directory with -p build-path\n"
       unless $count;
 
+    push @ARGV, map { corpus( $_ ) } split /,/, $opt_corpus;
+
     die
-      "No input file(s): expected some input file names as arguments to feed the benchmarks\n"
+      "No input file(s): expected some input file names or --corpus to feed the benchmarks\n"
       unless map { die  "[ERROR] No such file: $_\n" unless -f $_; } @ARGV;
 
-    say "Benchmarking $count programs against", scalar @ARGV, "input (${opt_repeats}x$opt_iterations times each):";
+    say "Benchmarking $count programs against", scalar @ARGV, "input (${opt_repeats}x$opt_iterations times each, on @opt_threads thread(s)):";
 
     run( \%programs );
 }
 
+sub corpus
+{
+    my ( $name ) = @_;
+
+    die "[ERROR] No such corpus: $name, try one of: @{[ sort keys %corpora ]}\n"
+      unless exists $corpora{ $name };
+
+    my $file = "$opt_build_directory/corpus.$name.$opt_corpus_size";
+    unless ( -f $file )
+    {
+        say "Generating $name corpus in $file";
+        system( "$opt_build_directory/generate $file --seed=1 --size=$opt_corpus_size $corpora{ $name }" ) == 0
+          or die "[ERROR] Failed to generate $file, build the generate program first\n";
+    }
+    return $file;
+}
+
 sub run
 {
     my ( $programs ) = @_;
@@ -90,10 +140,16 @@ sub run
     {
         for my $program ( @$programs )
         {
-            my $result = score( $benchmark, $program );
-            if ( $result )
+            for my $threads ( @opt_threads )
             {
-                push @{ $scores{ $benchmark } }, $result;
+                for my $batch ( $benchmark eq 'join' && @opt_batch ? @opt_batch : undef )
+                {
+                    my $result = score( $benchmark, $program, $threads, $batch );
+                    if ( $result )
+                    {
+                        push @{ $scores{ $benchmark } }, $result;
+                    }
+                }
             }
         }
     }
@@ -103,28 +159,35 @@ sub run
 
 sub score
 {
-    my ( $benchmark, $program ) = @_;
+    my ( $benchmark, $program, $threads, $batch ) = @_;
 
     my $name = basename( $program );
     if ( $name =~ /$opt_discard/o )
     {
         say "Skipping $name benchmark, use --discard=None to include" and return;
     }
+    if ( $threads > 1 and system( "$program --threads=$threads 2>/dev/null" ) >> 8 == ENOTSUP )
+    {
+        say "Skipping $name benchmark on $threads threads, it is single threaded" and return;
+    }
 
     tie my %score, 'Tie::IxHash',
-      name   => $name,
-      real   => 0,
-      user   => 0,
-      system => 0;
+      name    => $name,
+      threads => $threads,
+      real    => 0,
+      user    => 0,
+      system  => 0;
+    $score{ batch } = $batch if defined $batch;
 
     for my $input ( @ARGV )
     {
-        my $time = benckmark( $name, $program, $input );
+        my $time = benckmark( $name, $program, $input, $threads, $batch );
         if ( defined $time )
         {
             $score{ real }   += $time->{ real };
             $score{ user }   += $time->{ user };
             $score{ system } += $time->{ system };
+            accumulate( $score{ counters } ||= {}, $time->{ counters } ) if $time->{ counters };
             push @{ $score{ details } }, $time;
         }
         else
@@ -137,32 +200,56 @@ sub score
 
 sub benckmark
 {
-    my ( $name, $program, $input ) = @_;
+    my ( $name, $program, $input, $threads, $batch ) = @_;
 
-    say "Running $name against $input";
+    say "Running $name against $input on $threads thread(s)";
 
+    my $arguments = "$input $opt_iterations --threads=$threads --report=/dev/null";
+    $arguments .= " --map=$opt_map" if length $opt_map;
+    $arguments .= " --batch=$batch" if defined $batch;
     my $time_report = "time.$name\_$input";
     $time_report =~ s/[.\/]/_/g;
-    my $command =
-      "$opt_scheduling$OS_TIME --format=$opt_time_format --output=$time_report $program $input $opt_iterations";
+    my $sample_report = "samples.$time_report";
+    my $command = "$program $arguments --warmup=$opt_warmup --report=$sample_report"; # last --report wins
+    $command .= " --counters=$opt_counters" if length $opt_counters;
+    $command = "$OS_TIME --format=$opt_time_format --output=$time_report $command" unless $opt_in_process;
+    $command = "$opt_scheduling$command";
 
     my @results;
     eval {
         for ( 1 .. $opt_repeats )
         {
+            unlink( $sample_report );
             my $status = system( "$command > $opt_output" );
-            die "$OS_TIME returned $status.\n"
-              if $status;
-            my $result = do $time_report
-              or die
-              "unsupported $OS_TIME format in $time_report, use --time=/path/to/GNU/time.\n";
-            $status = $result->{ 'exit-status' };
-            die "$program returned $status, fix the code.\n" if $status;
+            my $samples = samples( $sample_report );
+            my $result;
+            if ( $opt_in_process )
+            {
+                die "$program returned $status, fix the code.\n" if $status;
+                $result = { real => 0, user => 0, system => 0 };
+                for my $sample ( @{ $samples->{ iterations } } )
+                {
+                    $result->{ real }   += $sample->{ nanoseconds } / 1e9;
+                    $result->{ user }   += $sample->{ user };
+                    $result->{ system } += $sample->{ system };
+                }
+            }
+            else
+            {
+                die "$OS_TIME returned $status.\n"
+                  if $status;
+                $result = do $time_report
+                  or die
+                  "unsupported $OS_TIME format in $time_report, use --time=/path/to/GNU/time.\n";
+                $status = $result->{ 'exit-status' };
+                die "$program returned $status, fix the code.\n" if $status;
+            }
+            $result->{ 'in-process' } = $samples;
             push @results, $result;
         }
     };
 
-    unlink( $time_report );
+    unlink( $time_report, $sample_report );
 
     if ( $@ )
     {
@@ -175,17 +262,22 @@ sub benckmark
     else
     {
         my $time = take_best( @results );
+        if ( length $opt_counters )
+        {
+            accumulate( $time->{ counters } ||= {}, $_->{ counters } )
+              for @{ $time->{ 'in-process' }{ iterations } };
+        }
         $time->{ 'input-data' } = $input;
         $time->{ 'code-size' }  = -s $program;
         if ( $opt_check )
         {
-            my $checksum = qx[$program $input $opt_iterations | $OS_HASH];
+            my $checksum = qx[$program $arguments | $OS_HASH];
             $checksum =~ s/ .*//s;
             $time->{ 'md5' } = $checksum;
         }
-        if ( $opt_valgrind )
+        if ( $opt_allocations )
         {
-            $time->{ 'valgrind' } = valgrind("$program $input $opt_iterations");
+            $time->{ 'allocations' } = allocations( "$program $arguments" );
         }
         return $time;
     }
@@ -220,18 +312,58 @@ sub fastest
     );
 }
 
-sub valgrind
+sub accumulate
+{
+    my ( $total, $counters ) = @_;
+
+    while ( my ( $event, $count ) = each %$counters )
+    {
+        $total->{ $event } += $count if defined $count;
+    }
+}
+
+sub samples
+{
+    my ( $report ) = @_;
+
+    my %samples = ( iterations => [] );
+
+    open my $lines, '<', $report or return \%samples;
+    while ( my $line = <$lines> )
+    {
+        my $sample = decode_json( $line );
+        my $event  = delete $sample->{ event };
+        delete @$sample{ qw(benchmark program) };
+        if ( $event eq 'index' )
+        {
+            $samples{ index } = $sample;
+        }
+        else
+        {
+            push @{ $samples{ iterations } }, $sample;
+        }
+    }
+    close $lines;
+
+    return \%samples;
+}
+
+sub allocations
 {
     my ( $command ) = @_;
 
-    my $report = qx[valgrind $command 2>&1];
+    my $profiler = "$opt_build_directory/liballocation-profiler.so";
+    die "[ERROR] No $profiler: build the allocation-profiler target first\n" unless -f $profiler;
+
+    my $report = qx[LD_PRELOAD=$profiler BENCHMARK_ALLOCATIONS=/dev/stderr $command 2>&1 >/dev/null];
 
     return
       if $?
-          or not my @valgrind = map { s/,//g; int($_) }
-          ( $report =~ /total heap usage: *(.*?) *allocs, *(.*?) *frees, *(.*?) *bytes/g );
+          or not $report =~ /^(\{"event": "allocations".*)$/m;
 
-    return { malloc => $valgrind[0], free => $valgrind[1], total => $valgrind[2] };
+    my $allocations = decode_json( $1 );
+    delete $allocations->{ event };
+    return $allocations;
 }
 
 main();
@@ -1,20 +1,24 @@
-
-/* Each benchmark must define an appropriate STR type. */
+/* Each benchmark must define an appropriate STR type, named by BENCHMARK_IMPLEMENTATION. */
 
 #ifdef USE_STD_STRING
 #include <string>
 typedef std::string STR;
+#define BENCHMARK_IMPLEMENTATION "std-string"
 #endif // USE_STD_STRING
 
 #ifdef USE_STD_STRING_GC
 #include <string>
 #include <gc/gc_allocator.h>
 typedef std::basic_string< char, std::char_traits<char>, gc_allocator<char> > STR;
+#define BENCHMARK_SINGLE_THREADED // threads would have to be registered with the collector
+#define BENCHMARK_IMPLEMENTATION "std-string-gc"
 #endif // USE_STD_STRING_GC
 
 #ifdef USE_PYTHON_STRING
 #include <Python.h>
 typedef PyStringObject STR;
+#define BENCHMARK_SINGLE_THREADED // the interpreter is not thread-safe without the GIL
+#define BENCHMARK_IMPLEMENTATION "python-string"
 #endif // USE_PYTHON_STRING
 
 #ifdef USE_PERL_STRING
@@ -22,6 +26,28 @@ typedef PyStringObject STR;
 #include <EXTERN.h>
 #include <perl.h>
 typedef SV STR;
+#define BENCHMARK_SINGLE_THREADED // one interpreter, one thread
+#ifdef BENCHMARK_DRIVER
+namespace benchmark
+{
+/**
+ * One interpreter for every entry of the driver, never destroyed:
+ * perl_destruct() closes the standard streams.
+ */
+inline PerlInterpreter* perl(int* argc, char*** argv)
+{
+    static PerlInterpreter* interpreter = 0;
+    if (not interpreter)
+    {
+        PERL_SYS_INIT(argc, argv);
+        interpreter = perl_alloc();
+        perl_construct(interpreter);
+    }
+    return interpreter;
+}
+} // benchmark namespace
+#define BENCHMARK_INIT    benchmark::perl(&argc, &argv);
+#else // Standalone program
 #define BENCHMARK_INIT    static PerlInterpreter *my_perl; \
                           PERL_SYS_INIT(&argc, &argv);     \
                           my_perl = perl_alloc();          \
@@ -29,24 +55,31 @@ typedef SV STR;
 #define BENCHMARK_FINISH  perl_destruct(my_perl); \
                           perl_free(my_perl);     \
                           PERL_SYS_TERM();
+#endif // BENCHMARK_DRIVER
+#define BENCHMARK_IMPLEMENTATION "perl-string"
 #endif // USE_PERL_STRING
 
 #ifdef USE_EXT_ROPE
 #include <ext/rope>
 typedef __gnu_cxx::rope<char> STR;
+#define BENCHMARK_IMPLEMENTATION "ext-rope"
 #endif // USE_EXT_ROPE
 
 #ifdef USE_GC_CORD
 extern "C"
 {
+#include <gc/gc.h>
 #include <gc/cord.h>
 }
 typedef CORD STR;
+#define BENCHMARK_SINGLE_THREADED // threads would have to be registered with the collector
+#define BENCHMARK_IMPLEMENTATION "gc-cord-dynamic"
 #endif // USE_GC_CORD
 
 #ifdef USE_CONST_STRING
 #include "boost/const_string/const_string.hpp"
 typedef boost::const_string<char> STR;
+#define BENCHMARK_IMPLEMENTATION "yegorushkin-const-string"
 #endif // USE_CONST_STRING
 
 #ifdef USE_BSTRLIB
@@ -54,14 +87,61 @@ typedef boost::const_string<char> STR;
 #define size   length
 #define substr midstr
 typedef Bstrlib::CBString STR;
+#define BENCHMARK_IMPLEMENTATION "bstring"
 #endif // USE_BSTRLIB
 
 #ifdef USE_QT4_STRING
 #include "QString"
 #define substr mid // may be more efficient with midRef (TODO: specialize the template to be fair)
 typedef QString STR;
+#define BENCHMARK_IMPLEMENTATION "qt4-string"
 #endif // USE_QT4_STRING
 
+#ifdef USE_STRING_VIEW
+/**
+ * Zero-copy: views borrow the records from the input mapping and substr()
+ * returns views. Streamed records stay valid while the chunk after
+ * theirs is processed, which covers the previous record (see stream.hpp).
+ * Views cannot be appended to, string-cat appends to a std::string instead.
+ */
+#include <string>
+#include <string_view>
+typedef std::string_view STR;
+#define BENCHMARK_IMPLEMENTATION "string-view"
+#endif // USE_STRING_VIEW
+
+#ifdef USE_ARENA_STRING
+#include "arena.hpp"
+typedef ArenaString STR;
+#define BENCHMARK_IMPLEMENTATION "arena-string"
+#endif // USE_ARENA_STRING
+
+#if defined(USE_PMR_STRING_MONOTONIC) or defined(USE_PMR_STRING_POOL)
+#include "pmr.hpp"
+typedef std::pmr::string STR;
+#ifdef USE_PMR_STRING_POOL
+#define BENCHMARK_IMPLEMENTATION "pmr-string-pool"
+#define BENCHMARK_INIT BENCHMARK_PMR_INIT(benchmark::resources::pool)
+#else // Monotonic
+#define BENCHMARK_IMPLEMENTATION "pmr-string-monotonic"
+#define BENCHMARK_INIT BENCHMARK_PMR_INIT(benchmark::resources::monotonic)
+#endif // USE_PMR_STRING_POOL
+#endif // USE_PMR_STRING_MONOTONIC or USE_PMR_STRING_POOL
+
+#ifdef USE_SMALL_STRING
+#include "small.hpp"
+typedef SmallString<USE_SMALL_STRING> STR;
+#define BENCHMARK_SMALL_STRING_(capacity) "small-string-" #capacity
+#define BENCHMARK_SMALL_STRING(capacity) BENCHMARK_SMALL_STRING_(capacity)
+#define BENCHMARK_IMPLEMENTATION BENCHMARK_SMALL_STRING(USE_SMALL_STRING)
+#endif // USE_SMALL_STRING
+
+#ifdef USE_BTREE_ROPE
+#include "rope.hpp"
+typedef BTreeRope STR;
+#define BENCHMARK_IMPLEMENTATION "btree-rope"
+#endif // USE_BTREE_ROPE
+
 #include <cstddef> // for size_t (defined here to avoid a clash with Python.h)
 
 #ifdef USE_NOTHING
@@ -75,9 +155,21 @@ struct NullString
     template<typename T>
     NullString(T) {}
 
+    template<typename T>
+    NullString(T, size_t) {}
+
     template<typename T>
     inline void operator+=(T) {}
 
+    template<typename T>
+    inline void append(T, size_t) {}
+
+    template<typename T>
+    inline void assign(T, size_t) {}
+
+    template<typename T>
+    inline void replace(size_t, size_t, T) {}
+
     template<typename T>
     inline void operator=(T) {}
 
@@ -87,6 +179,12 @@ struct NullString
         return false;
     }
 
+    template<typename T>
+    inline bool operator<(T) const
+    {
+        return false;
+    }
+
     inline size_t size() const
     {
         return 0;
@@ -96,11 +194,149 @@ struct NullString
     {
         return (*this);
     }
+
+    static const size_t npos = static_cast<size_t>(-1);
+
+    template<typename T>
+    inline size_t find(const T&, size_t = 0) const
+    {
+        return npos;
+    }
 };
 typedef NullString STR;
+#define BENCHMARK_IMPLEMENTATION "nop"
 #endif // USE_NOTHING
 
 #include "input.hpp"
+#include "parallel.hpp"
+#include "counters.hpp"
+#include "timing.hpp"
+#include "driver.hpp"
+
+namespace benchmark
+{
+
+/**
+ * Default and sized construction, assignment and concatenation.
+ * The record length is known, no implementation should scan for the NUL again.
+ * Allocator aware strings are given their allocator on construction.
+ */
+template<typename T>
+inline T construct()
+{
+    return T();
+}
+
+template<typename T>
+inline T make(const char* s, size_t n)
+{
+    return T(s, n);
+}
+
+template<typename T>
+inline void assign(T& str, const char* s, size_t n)
+{
+    str.assign(s, n);
+}
+
+template<typename T>
+inline void append(T& str, const char* s, size_t n)
+{
+    str.append(s, n);
+}
+
+#ifdef USE_EXT_ROPE
+template<>
+inline void assign<STR>(STR& str, const char* s, size_t n)
+{
+    str = STR(s, n);
+}
+#endif // USE_EXT_ROPE
+
+#ifdef USE_BSTRLIB
+template<>
+inline void assign<STR>(STR& str, const char* s, size_t n)
+{
+    if (bassignblk(&str, s, n) != BSTR_OK)
+    {
+        exit(ENOMEM);
+    }
+}
+
+template<>
+inline void append<STR>(STR& str, const char* s, size_t n)
+{
+    if (bcatblk(&str, s, n) != BSTR_OK)
+    {
+        exit(ENOMEM);
+    }
+}
+#endif // USE_BSTRLIB
+
+#ifdef USE_STRING_VIEW
+template<>
+inline void assign<STR>(STR& str, const char* s, size_t n)
+{
+    str = STR(s, n);
+}
+#endif // USE_STRING_VIEW
+
+#if defined(USE_PMR_STRING_MONOTONIC) or defined(USE_PMR_STRING_POOL)
+template<>
+inline STR construct<STR>()
+{
+    return STR(resources::local_());
+}
+
+template<>
+inline STR make<STR>(const char* s, size_t n)
+{
+    return STR(s, n, resources::local_());
+}
+#endif // USE_PMR_STRING_MONOTONIC or USE_PMR_STRING_POOL
+
+#ifdef USE_QT4_STRING
+template<>
+inline STR make<STR>(const char* s, size_t n)
+{
+    return QString::fromAscii(s, n);
+}
+
+template<>
+inline void assign<STR>(STR& str, const char* s, size_t n)
+{
+    str = QString::fromAscii(s, n);
+}
+
+template<>
+inline void append<STR>(STR& str, const char* s, size_t n)
+{
+    str += QString::fromAscii(s, n);
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * CORD_from_char_star() without the strlen().
+ */
+inline CORD cord(const char* s, size_t n)
+{
+    if (n == 0)
+    {
+        return CORD_EMPTY;
+    }
+    char* result = static_cast<char*>(GC_MALLOC_ATOMIC(n + 1));
+    if (result == 0)
+    {
+        exit(ENOMEM);
+    }
+    memcpy(result, s, n);
+    result[n] = '\0';
+    return result;
+}
+#endif // USE_GC_CORD
+
+} // benchmark namespace
 
 #ifndef BENCHMARK_INIT
 #define BENCHMARK_INIT
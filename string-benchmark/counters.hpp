@@ -0,0 +1,163 @@
+/**
+ * Hardware performance counters around the measured kernel.
+ *
+ * --counters=all or a comma separated list of event names opens one
+ * perf_event_open(2) group for the process (threads started later
+ * included), which is enabled for every iteration only.
+ * Events the processor or the kernel does not provide read as null.
+ */
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+namespace benchmark
+{
+
+struct event
+{
+    const char* name;
+    unsigned type;
+    unsigned long long config;
+};
+
+#define BENCHMARK_CACHE_EVENT(cache, op, result) \
+    (PERF_COUNT_HW_CACHE_##cache | (PERF_COUNT_HW_CACHE_OP_##op << 8) | (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+static const event events[] =
+{
+    { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "l1d-misses",    PERF_TYPE_HW_CACHE, BENCHMARK_CACHE_EVENT(L1D, READ, MISS) },
+    { "llc-misses",    PERF_TYPE_HW_CACHE, BENCHMARK_CACHE_EVENT(LL, READ, MISS) },
+    { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "dtlb-misses",   PERF_TYPE_HW_CACHE, BENCHMARK_CACHE_EVENT(DTLB, READ, MISS) },
+};
+
+static const int event_count = sizeof(events) / sizeof(events[0]);
+
+class counters
+{
+public:
+    counters(int argc, char* argv[]) : m_leader(-1), m_requested(option(argc, argv, "counters") != 0)
+    {
+        const char* const names = option(argc, argv, "counters");
+        for (int i = 0; i < event_count; ++i)
+        {
+            m_fd[i] = -1;
+            m_wanted[i] = names and (strcmp(names, "all") == 0 or listed(names, events[i].name));
+            if (m_wanted[i])
+            {
+                open_(i);
+            }
+        }
+    }
+
+    inline bool enabled_() const
+    {
+        return m_leader != -1;
+    }
+
+    inline void start_()
+    {
+        if (enabled_())
+        {
+            ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    inline void stop_()
+    {
+        if (enabled_())
+        {
+            ioctl(m_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    /**
+     * Writes the counts since start_() as a JSON object member, scaled when multiplexed.
+     */
+    void print_(FILE* report) const
+    {
+        if (not m_requested)
+        {
+            return;
+        }
+        fputs(", \"counters\": {", report);
+        const char* separator = "";
+        for (int i = 0; i < event_count; ++i)
+        {
+            if (not m_wanted[i])
+            {
+                continue;
+            }
+            fprintf(report, "%s\"%s\": ", separator, events[i].name);
+            separator = ", ";
+
+            unsigned long long value[3]; // value, time enabled, time running
+            if (m_fd[i] == -1 or read(m_fd[i], value, sizeof(value)) != sizeof(value))
+            {
+                fputs("null", report);
+            }
+            else if (value[2] != 0 and value[2] < value[1])
+            {
+                fprintf(report, "%.0f", static_cast<double>(value[0]) * value[1] / value[2]);
+            }
+            else
+            {
+                fprintf(report, "%llu", value[0]);
+            }
+        }
+        fputc('}', report);
+    }
+
+    ~counters()
+    {
+        for (int i = 0; i < event_count; ++i)
+        {
+            if (m_fd[i] != -1)
+            {
+                close(m_fd[i]);
+            }
+        }
+    }
+
+private:
+    counters(const counters&);
+    counters& operator=(const counters&);
+
+    void open_(int i)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = (m_leader == -1);
+        attr.inherit = 1; // count the shard threads as well.
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        m_fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, m_leader, 0);
+        if (m_fd[i] == -1)
+        {
+            if (errno == EACCES or errno == EPERM)
+            {
+                exit(errno); // see /proc/sys/kernel/perf_event_paranoid
+            }
+            return; // not supported here.
+        }
+        if (m_leader == -1)
+        {
+            m_leader = m_fd[i];
+        }
+    }
+
+    int m_fd[event_count];
+    bool m_wanted[event_count];
+    int m_leader;
+    const bool m_requested;
+};
+
+} // benchmark namespace
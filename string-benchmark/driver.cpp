@@ -0,0 +1,50 @@
+/**
+ * Every benchmark and implementation in one program.
+ *
+ *     $ ./driver DATA [ITERATIONS] --bench=cat,cmp --impl=std-string,bstring
+ *
+ * maps DATA once and runs the selected entries back to back (all of them
+ * by default), each as if it were its own program named BENCH-IMPL, so
+ * that their output and reports read the same. The per-process programs
+ * remain for measurements that need a fresh process.
+ */
+#include "input.hpp"
+#include "driver.hpp"
+
+int main(int argc, char* argv[])
+{
+    const char* const file_name = benchmark::argument(argc, argv, 1);
+    if (not file_name)
+    {
+        exit(-1);
+    }
+    const char* const benchmarks = benchmark::option(argc, argv, "bench");
+    const char* const implementations = benchmark::option(argc, argv, "impl");
+    const long threads = benchmark::threads(benchmark::option(argc, argv, "threads"), true); // entries are checked below.
+
+    benchmark::input data(file_name, argc, argv);
+    benchmark::registration::input_() = &data;
+
+    std::vector<char*> arguments(argv, argv + argc + 1);
+    char program[256];
+    arguments[0] = program;
+
+    int status = 0;
+    for (const benchmark::registration* r = benchmark::registration::first_(); r; r = r->next_())
+    {
+        if ((benchmarks and not benchmark::listed(benchmarks, r->name_()))
+            or (implementations and not benchmark::listed(implementations, r->implementation_())))
+        {
+            continue;
+        }
+        snprintf(program, sizeof(program), "%s-%s", r->name_(), r->implementation_());
+        if (threads > 1 and not r->thread_safe_())
+        {
+            fprintf(stderr, "%s: skipped, single threaded.\n", program);
+            continue;
+        }
+        status |= r->run_(argc, &arguments.front());
+        data.reset_();
+    }
+    return status;
+}
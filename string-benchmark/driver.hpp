@@ -0,0 +1,99 @@
+/**
+ * Registry of the benchmarks linked into the driver program.
+ *
+ * Built with -DBENCHMARK_DRIVER, the main function of a benchmark becomes
+ * an entry of the registry, named after the benchmark and the
+ * implementation it was compiled for (BENCHMARK_IMPLEMENTATION), and
+ * BENCHMARK_ACQUIRE_INPUT hands it the input shared by all entries.
+ * Otherwise BENCHMARK_MAIN is the usual main function.
+ */
+
+#ifdef BENCHMARK_DRIVER
+#define BENCHMARK_MAIN(name) static int main_(int argc, char* argv[]);                                 \
+                             static benchmark::registration registration_(name, BENCHMARK_IMPLEMENTATION, \
+                                                                          BENCHMARK_THREAD_SAFE, &main_); \
+                             static int main_(int argc, char* argv[])
+#else // Standalone program
+#define BENCHMARK_MAIN(name) int main(int argc, char* argv[])
+#endif // BENCHMARK_DRIVER
+
+#ifdef BENCHMARK_SINGLE_THREADED
+#define BENCHMARK_THREAD_SAFE false
+#else // Shards may run in threads
+#define BENCHMARK_THREAD_SAFE true
+#endif // BENCHMARK_SINGLE_THREADED
+
+namespace benchmark
+{
+
+class registration
+{
+public:
+    typedef int (*entry)(int argc, char* argv[]);
+
+    /**
+     * Appends to the registry, in link order.
+     */
+    registration(const char* const name, const char* const implementation, bool thread_safe, entry main)
+        : m_name(name), m_implementation(implementation), m_thread_safe(thread_safe), m_main(main), m_next(0)
+    {
+        registration** last = &first_();
+        while (*last)
+        {
+            last = &(*last)->m_next;
+        }
+        *last = this;
+    }
+
+    static registration*& first_()
+    {
+        static registration* first = 0;
+        return first;
+    }
+
+    /**
+     * The input of the running entry, owned by the driver.
+     */
+    static input*& input_()
+    {
+        static input* shared = 0;
+        return shared;
+    }
+
+    inline const char* name_() const
+    {
+        return m_name;
+    }
+
+    inline const char* implementation_() const
+    {
+        return m_implementation;
+    }
+
+    inline bool thread_safe_() const
+    {
+        return m_thread_safe;
+    }
+
+    inline registration* next_() const
+    {
+        return m_next;
+    }
+
+    inline int run_(int argc, char* argv[]) const
+    {
+        return m_main(argc, argv);
+    }
+
+private:
+    registration(const registration&);
+    registration& operator=(const registration&);
+
+    const char* const m_name;
+    const char* const m_implementation;
+    const bool m_thread_safe;
+    const entry m_main;
+    registration* m_next;
+};
+
+} // benchmark namespace
@@ -0,0 +1,203 @@
+/**
+ * Deterministic synthetic corpus generator.
+ *
+ *     $ ./generate [FILE] --seed=N --size=SIZE --length=DISTRIBUTION --alphabet=SET --duplicates=RATIO
+ *
+ * writes '\0' separated records to FILE (stdout by default), the same
+ * bytes for the same options on every machine:
+ *
+ *  --seed=N        pseudo random sequence (1)
+ *  --size=SIZE     total size, with an optional k, M or G suffix (64M)
+ *  --length=...    record lengths, one of (uniform:1:64)
+ *                    fixed:N
+ *                    uniform:MIN:MAX
+ *                    zipf:S:MAX      P(length = k) proportional to 1/k^S
+ *                    bimodal:T[:D]   half in [T-D+1, T], half in [T+1, T+D], D = 4:
+ *                                    around a small string optimization threshold T
+ *  --alphabet=...  lower, alnum, path or chars:LITERAL (alnum)
+ *  --duplicates=R  probability for a record to repeat the previous one (0)
+ */
+#include "input.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+namespace
+{
+
+/**
+ * splitmix64, the standard distributions are not the same everywhere.
+ */
+class generator
+{
+public:
+    explicit generator(unsigned long long seed) : m_state(seed)
+    {
+    }
+
+    unsigned long long operator()()
+    {
+        unsigned long long z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * Uniform in [low, high].
+     */
+    size_t between(size_t low, size_t high)
+    {
+        return low + (*this)() % (high - low + 1);
+    }
+
+    /**
+     * Uniform in [0, 1).
+     */
+    double real()
+    {
+        return ((*this)() >> 11) * (1.0 / (1ULL << 53));
+    }
+
+private:
+    unsigned long long m_state;
+};
+
+class lengths
+{
+public:
+    explicit lengths(const char* const spec) : m_kind(spec[0]), m_low(0), m_high(0)
+    {
+        double exponent = 0;
+        size_t spread = 4;
+        if (sscanf(spec, "fixed:%zu", &m_low) == 1)
+        {
+            m_high = m_low;
+        }
+        else if (sscanf(spec, "uniform:%zu:%zu", &m_low, &m_high) == 2)
+        {
+            if (m_low > m_high)
+            {
+                exit(EINVAL);
+            }
+        }
+        else if (sscanf(spec, "zipf:%lf:%zu", &exponent, &m_high) == 2 and exponent > 0 and m_high > 0)
+        {
+            double total = 0;
+            for (size_t k = 1; k <= m_high; ++k)
+            {
+                m_cdf.push_back(total += 1 / pow(k, exponent));
+            }
+            for (std::vector<double>::iterator p = m_cdf.begin(); p != m_cdf.end(); ++p)
+            {
+                *p /= total;
+            }
+        }
+        else if (sscanf(spec, "bimodal:%zu:%zu", &m_low, &spread) >= 1 and spread > 0 and spread <= m_low)
+        {
+            m_high = m_low + spread;
+            m_low = m_low - spread + 1;
+        }
+        else
+        {
+            exit(EINVAL);
+        }
+    }
+
+    size_t operator()(generator& next)
+    {
+        switch (m_kind)
+        {
+        case 'z':
+            return std::lower_bound(m_cdf.begin(), m_cdf.end(), next.real()) - m_cdf.begin() + 1;
+        default:
+            return next.between(m_low, m_high);
+        }
+    }
+
+private:
+    const char m_kind;
+    size_t m_low;
+    size_t m_high;
+    std::vector<double> m_cdf;
+};
+
+std::string alphabet(const char* const spec)
+{
+    static const char lower[] = "abcdefghijklmnopqrstuvwxyz";
+    static const char digits[] = "0123456789";
+    static const char upper[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    if (strcmp(spec, "lower") == 0)
+    {
+        return lower;
+    }
+    if (strcmp(spec, "alnum") == 0)
+    {
+        return std::string(lower) + upper + digits;
+    }
+    if (strcmp(spec, "path") == 0)
+    {
+        return std::string(lower) + lower + digits + "//////..-_";
+    }
+    if (strncmp(spec, "chars:", 6) == 0 and spec[6] != '\0')
+    {
+        return spec + 6;
+    }
+    exit(EINVAL);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    const char* const file_name = benchmark::argument(argc, argv, 1);
+    const char* const seed = benchmark::option(argc, argv, "seed");
+    const char* const size = benchmark::option(argc, argv, "size");
+    const char* const length = benchmark::option(argc, argv, "length");
+    const char* const chars = benchmark::option(argc, argv, "alphabet");
+    const char* const duplicates = benchmark::option(argc, argv, "duplicates");
+
+    generator next(seed ? strtoull(seed, 0, 10) : 1);
+    lengths draw(length ? length : "uniform:1:64");
+    const std::string letters = alphabet(chars ? chars : "alnum");
+    const double repeat = duplicates ? strtod(duplicates, 0) : 0;
+    const size_t total = size ? benchmark::bytes(size) : 64 << 20;
+
+    if (repeat < 0 or repeat > 1)
+    {
+        exit(EINVAL);
+    }
+
+    FILE* const output = (file_name and strcmp(file_name, "-") != 0) ? fopen(file_name, "w") : stdout;
+    if (output == 0)
+    {
+        exit(errno);
+    }
+
+    std::string record;
+    for (size_t written = 0; written < total; written += record.length() + 1)
+    {
+        if (written == 0 or next.real() >= repeat)
+        {
+            record.resize(std::min(draw(next), total - written - 1));
+            for (std::string::iterator c = record.begin(); c != record.end(); ++c)
+            {
+                *c = letters[next() % letters.length()];
+            }
+        }
+        else if (record.length() > total - written - 1)
+        {
+            record.resize(total - written - 1);
+        }
+        fwrite(record.data(), 1, record.length(), output);
+        putc_unlocked('\0', output);
+    }
+
+    if (fclose(output) != 0)
+    {
+        exit(errno);
+    }
+    return 0;
+}
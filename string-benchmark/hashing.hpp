@@ -0,0 +1,76 @@
+/**
+ * Hashing shared by the benchmarks with hash tables of their own (hash, intern).
+ *
+ * A 64 bit FNV-1a over the bytes of a string, and the hasher and equal
+ * functors of a std::unordered_set for the string types that have no
+ * std::hash or no operator== of their own.
+ */
+inline size_t fnv1a(const char* s, size_t n)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (const char* const end = s + n; s != end; ++s)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*s)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+template<typename T>
+struct hasher
+{
+    inline size_t operator()(const T& str) const
+    {
+        return fnv1a(str.data(), str.size());
+    }
+};
+
+template<typename T>
+struct equal
+{
+    inline bool operator()(const T& a, const T& b) const
+    {
+        return a == b;
+    }
+};
+
+#ifdef USE_EXT_ROPE
+template<>
+struct hasher<STR>
+{
+    inline size_t operator()(const STR& str) const
+    {
+        return fnv1a(str.c_str(), str.size()); // flattens.
+    }
+};
+#endif // USE_EXT_ROPE
+
+#ifdef USE_BSTRLIB
+template<>
+struct hasher<STR>
+{
+    inline size_t operator()(const STR& str) const
+    {
+        return fnv1a(reinterpret_cast<const char*>(str.data), str.slen);
+    }
+};
+#endif // USE_BSTRLIB
+
+#ifdef USE_GC_CORD
+template<>
+struct hasher<CORD>
+{
+    inline size_t operator()(CORD str) const
+    {
+        return fnv1a(CORD_to_const_char_star(str), CORD_len(str));
+    }
+};
+
+template<>
+struct equal<CORD>
+{
+    inline bool operator()(CORD a, CORD b) const
+    {
+        return CORD_cmp(a, b) == 0;
+    }
+};
+#endif // USE_GC_CORD
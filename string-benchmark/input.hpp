@@ -1,35 +1,59 @@
 /**
- * mmap based string acquisition.
+ * mmap based string acquisition, see stream.hpp for pipes.
  */
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 #include <cerrno>
+#include <ctime>
 #include <utility>
+#include <vector>
 
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
 #include <unistd.h>
 
-#define BENCHMARK_ACQUIRE_INPUT(data)  if(argc < 2) { exit(-1); } benchmark::input data(argv[1]);
-#define BENCHMARK_GET_ITERATIONS(iter) long iter = (argc > 2) ? benchmark::iterations(argv[2]) : 1;
-#define BENCHMARK_ITERATE(input, iter) for (int i_ = 0; i_ < iter; ++i_, input.reset_())
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "stream.hpp"
+
+#ifndef BENCHMARK_REWIND // see arena.hpp
+#define BENCHMARK_REWIND()             ((void)0)
+#endif // BENCHMARK_REWIND
+
+#ifdef BENCHMARK_DRIVER // see driver.hpp
+#define BENCHMARK_ACQUIRE_INPUT(data)  benchmark::input& data = *benchmark::registration::input_();
+#else // Standalone program
+#define BENCHMARK_ACQUIRE_INPUT(data)  const char* const data##_file_ = benchmark::argument(argc, argv, 1); \
+                                       if(not data##_file_) { exit(-1); } benchmark::input data(data##_file_, argc, argv);
+#endif // BENCHMARK_DRIVER
+#define BENCHMARK_GET_ITERATIONS(iter) const char* const iter##_ = benchmark::argument(argc, argv, 2); \
+                                       long iter = iter##_ ? benchmark::iterations(iter##_) : 1;
+#define BENCHMARK_GET_THREADS(threads) long threads = benchmark::threads(benchmark::option(argc, argv, "threads"), BENCHMARK_THREAD_SAFE);
+#define BENCHMARK_ITERATE(input, iter) for (long i_ = -benchmark::warmup(argc, argv); i_ < iter; ++i_, input.reset_(), BENCHMARK_REWIND())
 #define BENCHMARK_FOREACH(cstring)     for(const char *cstring; not input.eof_() and (cstring = input.next_().first); /* Empty */)
+#define BENCHMARK_FOREACH_RECORD(cstring, length) \
+                                       for(size_t length, once_ = 1; once_; once_ = 0) \
+                                       for(const char *cstring; not input.eof_() and (cstring = input.next_(length)); /* Empty */)
 
+// Output goes to the stream of the input being processed, so that shards can be buffered separately.
 #if _POSIX_C_SOURCE >= 1 or _XOPEN_SOURCE or _POSIX_SOURCE or _BSD_SOURCE or _SVID_SOURCE
-#define PUTCHAR putchar_unlocked
+#define PUTCHAR(c) putc_unlocked((c), input.output_())
 #else // Standard I/O
-#define PUTCHAR putchar
+#define PUTCHAR(c) putc((c), input.output_())
 #endif
 
 namespace benchmark
 {
 
-long iterations(const char* const argv)
+inline long iterations(const char* const argv)
 {
     const long iter = labs(strtol(argv, 0, 10));
     if (iter == 0 or errno)
@@ -39,13 +63,332 @@ long iterations(const char* const argv)
     return iter;
 }
 
+/**
+ * Value of the last --name=value command line option, or 0 when absent.
+ */
+inline const char* option(int argc, char* argv[], const char* const name)
+{
+    const size_t length = strlen(name);
+    const char* value = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        if (arg[0] == '-' and arg[1] == '-' and strncmp(arg + 2, name, length) == 0 and arg[length + 2] == '=')
+        {
+            value = arg + length + 3;
+        }
+    }
+    return value;
+}
+
+/**
+ * Whether name is one of the comma separated names.
+ */
+inline bool listed(const char* names, const char* const name)
+{
+    const size_t length = strlen(name);
+    for (; names; names = strchr(names, ','), names = names ? names + 1 : 0)
+    {
+        if (strncmp(names, name, length) == 0 and (names[length] == ',' or names[length] == '\0'))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Positional command line argument (options excluded), or 0 when absent.
+ */
+inline const char* argument(int argc, char* argv[], int index)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--", 2) != 0 and --index == 0)
+        {
+            return argv[i];
+        }
+    }
+    return 0;
+}
+
+/**
+ * A size in bytes, with an optional k, M or G suffix.
+ */
+inline size_t bytes(const char* const argv)
+{
+    char* end;
+    const double size = strtod(argv, &end);
+    const double scale = (*end == 'k') ? 1 << 10 : (*end == 'M') ? 1 << 20 : (*end == 'G') ? 1 << 30 : 1;
+    if (size * scale < 1 or (*end != '\0' and (scale == 1 or end[1] != '\0')))
+    {
+        exit(EINVAL);
+    }
+    return size * scale;
+}
+
+/**
+ * Thread count of the --threads option, thread_safe is BENCHMARK_THREAD_SAFE
+ * of the calling translation unit (see driver.hpp).
+ */
+inline long threads(const char* const argv, bool thread_safe)
+{
+    const long count = argv ? iterations(argv) : 1;
+    if (count > 1 and not thread_safe)
+    {
+        exit(ENOTSUP); // the implementation cannot be shared between threads.
+    }
+    return count;
+}
+
+/**
+ * Seconds elapsed on the monotonic clock.
+ */
+inline double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Appends the start of every record following a NUL in [begin, end) to starts.
+ * The NUL bytes are located 32 (AVX2) or 16 (SSE2) bytes at a time.
+ */
+template<typename Iterator>
+inline void scan(Iterator begin, Iterator end, std::vector<Iterator>& starts)
+{
+    Iterator at = begin;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for (; end - at >= 32; at += 32)
+    {
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(at)), zero));
+        for (; mask; mask &= mask - 1)
+        {
+            starts.push_back(at + __builtin_ctz(mask) + 1);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; end - at >= 16; at += 16)
+    {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(at)), zero));
+        for (; mask; mask &= mask - 1)
+        {
+            starts.push_back(at + __builtin_ctz(mask) + 1);
+        }
+    }
+#endif
+    for (; at < end; ++at)
+    {
+        if (*at == '\0')
+        {
+            starts.push_back(at + 1);
+        }
+    }
+}
+
+/**
+ * The records are indexed once when the input is opened, so that
+ * iterating is a mere array step and does not charge a NUL scan
+ * to every implementation on every iteration.
+ *
+ * Anything but a regular file ("-" is the standard input) is streamed
+ * instead, one chunk of --buffer=SIZE bytes (64M) at a time, indexed
+ * as it comes. A stream can only be read once, unless --spill=FILE
+ * keeps a copy of it that the next iterations map.
+ *
+ * --map=POLICY[,POLICY] decides how files are mapped:
+ *  populate    prefault the whole mapping (MAP_POPULATE)
+ *  sequential  madvise(MADV_SEQUENTIAL)
+ *  willneed    madvise(MADV_WILLNEED), start reading ahead
+ *  hugepage    madvise(MADV_HUGEPAGE), needs huge pages for files
+ *  copy        copy into anonymous, transparent huge pages
+ * The time and page faults of opening the input are reported apart
+ * from the iterations.
+ */
 class input
 {
 public:
     typedef char* iterator;
     typedef const std::pair<const iterator, size_t> record;
 
-    input(const char* const file_name) : m_fd(open(file_name, O_RDONLY))
+    input(const char* const file_name, int argc, char* argv[])
+        : m_end(0), m_begin(0), m_length(0), m_policy(option(argc, argv, "map")), m_mapping(0), m_indexing(0),
+          m_output(stdout), m_fd(strcmp(file_name, "-") == 0 ? dup(STDIN_FILENO) : open(file_name, O_RDONLY)),
+          m_spill(-1), m_stream(0), m_rewound(false), m_whole(this), m_carried(0)
+    {
+        struct rusage before;
+        getrusage(RUSAGE_SELF, &before);
+        open_(argc, argv);
+        struct rusage after;
+        getrusage(RUSAGE_SELF, &after);
+        m_minor_faults = after.ru_minflt - before.ru_minflt;
+        m_major_faults = after.ru_majflt - before.ru_majflt;
+    }
+
+    /**
+     * Shard over the records [first, last) of another input, which must outlive it.
+     */
+    input(const input& whole, const iterator* first, const iterator* last, FILE* output)
+        : m_cursor(first), m_first(first), m_last(last), m_end(0), m_begin(0), m_length(0), m_policy(0),
+          m_mapping(0), m_indexing(0), m_minor_faults(0), m_major_faults(0),
+          m_output(output), m_fd(-1), m_spill(-1), m_stream(0), m_rewound(false), m_whole(&whole), m_carried(0)
+    {
+    }
+
+    inline const iterator* first_() const
+    {
+        return m_first;
+    }
+
+    inline const iterator* last_() const
+    {
+        return m_last;
+    }
+
+    inline unsigned long records_() const
+    {
+        return m_last - m_first;
+    }
+
+    inline unsigned long bytes_() const
+    {
+        return *m_last - *m_first;
+    }
+
+    /**
+     * Seconds spent indexing the records, not part of any iteration unless streaming.
+     */
+    inline double indexing_() const
+    {
+        return m_indexing;
+    }
+
+    /**
+     * Seconds spent mapping (and copying, with --map=copy) the input.
+     */
+    inline double mapping_() const
+    {
+        return m_mapping;
+    }
+
+    /**
+     * Page faults while opening the input, mapping and indexing included.
+     */
+    inline long minor_faults_() const
+    {
+        return m_minor_faults;
+    }
+
+    inline long major_faults_() const
+    {
+        return m_major_faults;
+    }
+
+    inline FILE* output_() const
+    {
+        return m_output;
+    }
+
+    /**
+     * The record back records before the first one of this input, so that
+     * shards start from the state a serial run would be in. 0, and a length
+     * of 0, before the start of the input.
+     */
+    const char* preceding_(size_t back, size_t& length) const
+    {
+        const size_t within = m_first - m_whole->m_first;
+        if (back <= within)
+        {
+            const iterator at = m_first[-back];
+            length = m_first[1 - back] - at - 1;
+            return at;
+        }
+        back -= within;
+        if (back > m_whole->m_carried)
+        {
+            length = 0;
+            return 0;
+        }
+        const std::vector<char>& carried = m_whole->m_behind[back - 1];
+        length = carried.end() - carried.begin();
+        return carried.data();
+    }
+
+    inline bool eof_()
+    {
+        return (m_cursor == m_last) and not refill_();
+    }
+
+    inline void reset_()
+    {
+        if (m_stream)
+        {
+            rewind_();
+        }
+        m_cursor = m_first;
+    }
+
+    /**
+     * Moves on to the next chunk of a stream, false at the end of the input.
+     */
+    bool refill_()
+    {
+        if (not m_stream)
+        {
+            return false;
+        }
+        if (m_rewound)
+        {
+            exit(ESPIPE); // cannot read a stream twice, see --spill.
+        }
+        carry_();
+        iterator begin, end;
+        if (not m_stream->next_(begin, end))
+        {
+            return false;
+        }
+        index_(begin, end);
+        return true;
+    }
+
+    inline record next_()
+    {
+        const iterator at = *m_cursor++;
+        return record(at, *m_cursor - at - 1);
+    }
+
+    inline const char* next_(size_t& length)
+    {
+        const iterator at = *m_cursor++;
+        length = *m_cursor - at - 1;
+        return at;
+    }
+
+    ~input()
+    {
+        delete m_stream;
+        if (m_begin)
+        {
+            munmap(m_begin, m_length);
+        }
+        if (m_spill != -1)
+        {
+            close(m_spill);
+        }
+        if (m_fd != -1)
+        {
+            close(m_fd);
+        }
+    }
+
+private:
+    input(const input&);
+    input& operator=(const input&);
+
+    void open_(int argc, char* argv[])
     {
         struct stat buf;
         if (m_fd == -1 or fstat(m_fd, &buf) == -1)
@@ -53,51 +396,163 @@ public:
             exit(errno);
         }
 
-        m_begin = static_cast<iterator>(mmap(0, buf.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0));
+        if (S_ISREG(buf.st_mode))
+        {
+            map_(m_fd, buf.st_size);
+            return;
+        }
+
+        const char* const spill = option(argc, argv, "spill");
+        if (spill and (m_spill = open(spill, O_RDWR | O_CREAT | O_TRUNC, 0644)) == -1)
+        {
+            exit(errno);
+        }
+        const char* const size = option(argc, argv, "buffer");
+        const char* const threaded = option(argc, argv, "reader-thread");
+        m_stream = new stream(m_fd, size ? bytes(size) : 64 << 20, not threaded or strcmp(threaded, "no") != 0, m_spill);
+        if (not refill_())
+        {
+            exit(EFBIG); // stream must not be empty.
+        }
+    }
+
+    void map_(int fd, size_t size)
+    {
+        const double start = now();
+        const int flags = MAP_PRIVATE | (listed(m_policy, "populate") ? MAP_POPULATE : 0);
+        m_begin = static_cast<iterator>(mmap(0, size, PROT_READ, flags, fd, 0));
         if (m_begin == iterator(-1))
         {
             exit(errno);
         }
+        m_length = size;
+
+        // advice is only a hint, failures are ignored.
+        if (listed(m_policy, "sequential"))
+        {
+            madvise(m_begin, size, MADV_SEQUENTIAL);
+        }
+        if (listed(m_policy, "willneed"))
+        {
+            madvise(m_begin, size, MADV_WILLNEED);
+        }
+        if (listed(m_policy, "hugepage"))
+        {
+            madvise(m_begin, size, MADV_HUGEPAGE);
+        }
+        if (listed(m_policy, "copy"))
+        {
+            copy_(size);
+        }
 
-        m_end = m_begin + buf.st_size;
-        m_position = m_begin;
+        m_end = m_begin + size;
+        m_mapping += now() - start;
 
         if (m_end <= m_begin or m_end[-1] != '\0')
         {
             exit(EFBIG); // file must be non-empty and last byte must be NUL.
         }
-    }
 
-    inline bool eof_() const
-    {
-        return (m_position >= m_end);
+        index_(m_begin, m_end);
     }
 
-    inline void reset_()
+    /**
+     * Replaces the file mapping by an anonymous one in huge pages when available.
+     */
+    void copy_(size_t size)
     {
-        m_position = m_begin;
+        const size_t huge = 2 << 20;
+        const size_t rounded = (size + huge - 1) / huge * huge;
+        const iterator copy = static_cast<iterator>(mmap(0, rounded, PROT_READ | PROT_WRITE,
+                                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (copy == iterator(-1))
+        {
+            exit(errno);
+        }
+        madvise(copy, rounded, MADV_HUGEPAGE);
+        memcpy(copy, m_begin, size);
+        munmap(m_begin, m_length);
+        mprotect(copy, rounded, PROT_READ);
+        m_begin = copy;
+        m_length = rounded;
     }
 
-    inline record next_()
+    /**
+     * Copies the last two records read, which the next chunk looks back to, before the stream reuses their buffer.
+     */
+    void carry_()
     {
-        const iterator at = m_position;
-        if (at < m_end)
+        if (m_index.begin() == m_index.end())
+        {
+            return;
+        }
+        for (const iterator* at = m_last - m_first > 2 ? m_last - 2 : m_first; at != m_last; ++at)
         {
-            m_position += strlen(m_position);
+            m_behind[1].swap(m_behind[0]);
+            m_behind[0].assign(at[0], at[1] - 1);
+            m_carried += m_carried < 2;
         }
-        return record(at, m_position++ - at);
     }
 
-    ~input()
+    void index_(iterator begin, iterator end)
     {
-        close(m_fd);
-        munmap(m_begin, m_end - m_begin);
+        const double start = now();
+        m_index.clear();
+        m_index.push_back(begin);
+        scan(begin, end, m_index); // the last NUL yields end, which ends the last record.
+        m_indexing += now() - start;
+
+        m_first = &m_index.front();
+        m_last = &m_index.back();
+        m_cursor = m_first;
     }
 
-private:
-    iterator m_position;
+    /**
+     * Once a stream has been read, the next iterations map its spill file.
+     */
+    void rewind_()
+    {
+        if (m_spill == -1)
+        {
+            m_rewound = true;
+            m_first = m_last; // reading on is an error.
+            return;
+        }
+        while (refill_())
+        {
+            // drain what the iteration left, so that the spill file is complete.
+        }
+        delete m_stream;
+        m_stream = 0;
+        m_carried = 0;
+
+        struct stat buf;
+        if (fstat(m_spill, &buf) == -1)
+        {
+            exit(errno);
+        }
+        map_(m_spill, buf.st_size);
+    }
+
+    std::vector<iterator> m_index; // start of each record, followed by the end of the last one.
+    const iterator* m_cursor;
+    const iterator* m_first;
+    const iterator* m_last;
     iterator m_end;
     iterator m_begin;
+    size_t m_length; // of the mapping.
+    const char* m_policy;
+    double m_mapping;
+    double m_indexing;
+    long m_minor_faults;
+    long m_major_faults;
+    FILE* m_output;
     int m_fd;
+    int m_spill;
+    stream* m_stream;
+    bool m_rewound;
+    const input* m_whole; // this, or the input a shard is part of.
+    std::vector<char> m_behind[2]; // the last records of the previous chunks of a stream, latest first.
+    size_t m_carried;
 };
 } // benchmark namespace
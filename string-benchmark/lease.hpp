@@ -0,0 +1,86 @@
+/**
+ * Per-thread objects, leased from a pool the program owns.
+ *
+ * leased<R>::local_() hands every thread an R of its own, taken from the
+ * pool on first use and given back when the thread ends, so that the
+ * shards of the next pass reuse what those of the last one built up
+ * (arenas, memory resources). Nothing is ever freed.
+ */
+#include <vector>
+
+#include <pthread.h>
+
+namespace benchmark
+{
+
+template<typename R>
+class leased
+{
+public:
+    /**
+     * The object of the calling thread.
+     */
+    static inline R& local_()
+    {
+        static thread_local lease held;
+        return *held.object;
+    }
+
+    /**
+     * Calls f on every object, leased or not: between passes only.
+     */
+    template<typename F>
+    static void for_each_(F& f)
+    {
+        pool& all = pool_();
+        pthread_mutex_lock(&all.mutex);
+        for (typename std::vector<R*>::const_iterator object = all.objects.begin(); object != all.objects.end(); ++object)
+        {
+            f(**object);
+        }
+        pthread_mutex_unlock(&all.mutex);
+    }
+
+private:
+    struct pool
+    {
+        pthread_mutex_t mutex;
+        std::vector<R*> objects; // all of them, leased or not.
+        std::vector<R*> idle;
+    };
+
+    struct lease
+    {
+        R* object;
+
+        lease()
+        {
+            pool& all = pool_();
+            pthread_mutex_lock(&all.mutex);
+            if (all.idle.begin() == all.idle.end())
+            {
+                all.objects.push_back(new R);
+                all.idle.push_back(all.objects.back());
+            }
+            object = all.idle.back();
+            all.idle.pop_back();
+            pthread_mutex_unlock(&all.mutex);
+        }
+
+        ~lease()
+        {
+            pool& all = pool_();
+            pthread_mutex_lock(&all.mutex);
+            all.idle.push_back(object);
+            pthread_mutex_unlock(&all.mutex);
+        }
+    };
+
+    static pool& pool_()
+    {
+        static pool all = { PTHREAD_MUTEX_INITIALIZER, std::vector<R*>(), std::vector<R*>() };
+        return all;
+    }
+};
+
+} // benchmark namespace
@@ -0,0 +1,138 @@
+/**
+ * Sharded execution of a benchmark kernel.
+ *
+ * The records are split into as many contiguous partitions as there are
+ * threads, each partition is processed by its own thread, and the
+ * per-thread results are combined: summed for counting kernels, and
+ * concatenated in partition order for kernels that print.
+ *
+ * Kernels that look back at previous records (cmp, slice) start every
+ * shard from the records before it (input::preceding_()), so any number
+ * of threads reproduces the serial output. The single threaded
+ * implementations do not need to.
+ *
+ * Beware: config.hpp may #define size and substr away before this point.
+ */
+#include <algorithm>
+#include <vector>
+
+#include <pthread.h>
+
+namespace benchmark
+{
+
+template<typename R>
+struct task
+{
+    R (*kernel)(input&);
+    input* data;
+    R result;
+
+    static void* start(void* self)
+    {
+        task& t = *static_cast<task*>(self);
+        t.result = t.kernel(*t.data);
+        return 0;
+    }
+};
+
+template<>
+struct task<void>
+{
+    void (*kernel)(input&);
+    input* data;
+
+    static void* start(void* self)
+    {
+        task& t = *static_cast<task*>(self);
+        t.kernel(*t.data);
+        return 0;
+    }
+};
+
+template<typename R>
+inline R combine(const std::vector< task<R> >& tasks)
+{
+    R result = R();
+    for (typename std::vector< task<R> >::const_iterator t = tasks.begin(); t != tasks.end(); ++t)
+    {
+        result += t->result;
+    }
+    return result;
+}
+
+template<>
+inline void combine<void>(const std::vector< task<void> >&)
+{
+}
+
+/**
+ * Runs kernel over the current records of data split across threads, appending to tasks.
+ */
+template<typename R>
+void shard(input& data, long threads, R (*kernel)(input&), std::vector< task<R> >& tasks)
+{
+    const unsigned long bytes = data.bytes_();
+    const long first = tasks.end() - tasks.begin();
+    tasks.resize(first + threads);
+    std::vector<pthread_t> ids(threads);
+    std::vector<char*> buffers(threads);
+    std::vector<size_t> lengths(threads);
+    std::vector<FILE*> outputs(threads);
+
+    const input::iterator* from = data.first_();
+    for (long i = 0; i < threads; ++i)
+    {
+        // first record starting at or after an even share of the bytes.
+        const input::iterator* to = std::lower_bound(from, data.last_(), *data.first_() + bytes * (i + 1) / threads);
+        outputs[i] = open_memstream(&buffers[i], &lengths[i]);
+        if (outputs[i] == 0)
+        {
+            exit(errno);
+        }
+        tasks[first + i].kernel = kernel;
+        tasks[first + i].data = new input(data, from, to, outputs[i]);
+        from = to;
+    }
+
+    for (long i = 0; i < threads; ++i)
+    {
+        if (pthread_create(&ids[i], 0, &task<R>::start, &tasks[first + i]) != 0)
+        {
+            exit(EAGAIN);
+        }
+    }
+
+    for (long i = 0; i < threads; ++i)
+    {
+        pthread_join(ids[i], 0);
+        delete tasks[first + i].data;
+        fclose(outputs[i]);
+        fwrite(buffers[i], 1, lengths[i], data.output_());
+        free(buffers[i]);
+    }
+}
+
+/**
+ * Runs kernel over data split across the given number of threads,
+ * one chunk after the other when data is streamed.
+ */
+template<typename R>
+R run(input& data, long threads, R (*kernel)(input&))
+{
+    if (threads <= 1)
+    {
+        return kernel(data);
+    }
+
+    std::vector< task<R> > tasks;
+    do
+    {
+        shard(data, threads, kernel, tasks);
+    }
+    while (data.refill_());
+
+    return combine(tasks);
+}
+
+} // benchmark namespace
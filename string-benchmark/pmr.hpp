@@ -0,0 +1,118 @@
+/**
+ * std::pmr::string over a memory resource of the thread that builds it.
+ *
+ * Every thread has a monotonic_buffer_resource and an
+ * unsynchronized_pool_resource of its own (see lease.hpp), the
+ * implementation picks which one strings allocate from. Both draw from an
+ * upstream buffer of --upstream=SIZE bytes reserved and touched once per
+ * thread, new and delete beyond it (and without it). BENCHMARK_ITERATE
+ * releases everything before the next pass.
+ *
+ * Only benchmark::construct() and benchmark::make() hand out the resource,
+ * and string-slice's substring(): copies are made with the default one,
+ * and so is substr() as the standard specifies it.
+ */
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+
+#include "lease.hpp"
+
+#define BENCHMARK_PMR_INIT(kind) { const char* const upstream_ = benchmark::option(argc, argv, "upstream"); \
+                                   benchmark::resources::configure_(kind, upstream_ ? benchmark::bytes(upstream_) : 0); }
+#define BENCHMARK_REWIND() benchmark::resources::release_all_()
+
+namespace benchmark
+{
+
+class resources
+{
+public:
+    enum kind { monotonic, pool };
+
+    /**
+     * Chooses the resource, and the upstream size of the threads to come.
+     */
+    static void configure_(kind chosen, size_t upstream)
+    {
+        settings_().chosen = chosen;
+        settings_().upstream = upstream;
+    }
+
+    /**
+     * The chosen resource of the calling thread.
+     */
+    static inline std::pmr::memory_resource* local_()
+    {
+        resources& local = leased<resources>::local_();
+        if (settings_().chosen == pool)
+        {
+            return &local.m_pool;
+        }
+        return &local.m_monotonic;
+    }
+
+    /**
+     * Frees every allocation of every thread, between passes only.
+     */
+    static void release_all_()
+    {
+        release releaser;
+        leased<resources>::for_each_(releaser);
+    }
+
+    resources() : m_buffer(0), m_upstream(0), m_monotonic(upstream_()), m_pool(m_monotonic.upstream_resource())
+    {
+    }
+
+private:
+    struct settings
+    {
+        kind chosen;
+        size_t upstream;
+    };
+
+    struct release
+    {
+        inline void operator()(resources& r) const
+        {
+            r.m_monotonic.release();
+            r.m_pool.release();
+            if (r.m_upstream)
+            {
+                r.m_upstream->release();
+            }
+        }
+    };
+
+    static settings& settings_()
+    {
+        static settings current = { monotonic, 0 };
+        return current;
+    }
+
+    std::pmr::memory_resource* upstream_()
+    {
+        const size_t size = settings_().upstream;
+        if (size == 0)
+        {
+            return std::pmr::new_delete_resource();
+        }
+        if ((m_buffer = static_cast<char*>(malloc(size))) == 0)
+        {
+            exit(ENOMEM);
+        }
+        memset(m_buffer, 0, size);
+        m_upstream = new std::pmr::monotonic_buffer_resource(m_buffer, size, std::pmr::new_delete_resource());
+        return m_upstream;
+    }
+
+    char* m_buffer; // never freed, resources live as long as the program.
+    std::pmr::monotonic_buffer_resource* m_upstream;
+    std::pmr::monotonic_buffer_resource m_monotonic;
+    std::pmr::unsynchronized_pool_resource m_pool;
+};
+
+} // benchmark namespace
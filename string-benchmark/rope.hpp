@@ -0,0 +1,405 @@
+/**
+ * B+-tree rope over cache line sized leaves.
+ *
+ * Leaves are 64 byte nodes holding up to 56 characters, branches hold up
+ * to 16 children with the length of every subtree cached, so positions
+ * are found in O(log n). Nodes are reference counted and shared between
+ * ropes, copies are O(1) and only the shared nodes on a path being
+ * modified are copied.
+ *
+ * Appends fill a tail leaf kept out of the tree, which is pushed down the
+ * right edge once full: amortized O(1) per character. substr() shares the
+ * subtrees inside the range and copies the O(log n) nodes on its edges;
+ * the result may have leaves at different depths but is never deeper
+ * than the source. flatten_() copies the characters out in one pass over
+ * the leaves.
+ *
+ * Reference counts are not atomic: ropes are not shared between threads.
+ */
+#include <algorithm>
+#include <cstring>
+
+class BTreeRope
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    BTreeRope() : m_root(0), m_tail(0), m_size(0)
+    {
+    }
+
+    BTreeRope(const char* s, size_t n) : m_root(0), m_tail(0), m_size(0)
+    {
+        append(s, n);
+    }
+
+    BTreeRope(const BTreeRope& other) : m_root(ref_(other.m_root)), m_tail(ref_(other.m_tail)), m_size(other.m_size)
+    {
+    }
+
+    ~BTreeRope()
+    {
+        unref_(m_root);
+        unref_(m_tail);
+    }
+
+    inline BTreeRope& operator=(const BTreeRope& other)
+    {
+        node* const root = ref_(other.m_root);
+        leaf* const tail = ref_(other.m_tail);
+        unref_(m_root);
+        unref_(m_tail);
+        m_root = root;
+        m_tail = tail;
+        m_size = other.m_size;
+        return *this;
+    }
+
+    inline void assign(const char* s, size_t n)
+    {
+        unref_(m_root);
+        unref_(m_tail);
+        m_root = m_tail = 0;
+        m_size = 0;
+        append(s, n);
+    }
+
+    void append(const char* s, size_t n)
+    {
+        m_size += n;
+        while (n)
+        {
+            if (m_tail == 0)
+            {
+                m_tail = new leaf;
+            }
+            else if (m_tail->refs > 1)
+            {
+                leaf* const copy = new leaf(*m_tail);
+                copy->refs = 1;
+                unref_(m_tail);
+                m_tail = copy;
+            }
+            const size_t taken = std::min(n, leaf::chunk - m_tail->count);
+            memcpy(m_tail->bytes + m_tail->count, s, taken);
+            m_tail->count += taken;
+            s += taken;
+            n -= taken;
+            if (m_tail->count == leaf::chunk)
+            {
+                push_(m_tail);
+                m_tail = 0;
+            }
+        }
+    }
+
+    bool operator==(const BTreeRope& other) const
+    {
+        if (m_size != other.m_size)
+        {
+            return false;
+        }
+        if (m_root == other.m_root and m_tail == other.m_tail)
+        {
+            return true;
+        }
+        cursor a(*this), b(other);
+        const char* p = 0;
+        const char* q = 0;
+        size_t n = 0, m = 0;
+        for (;;)
+        {
+            if (n == 0 and not a.next_(p, n))
+            {
+                return true; // and b is done too, the sizes are equal.
+            }
+            if (m == 0)
+            {
+                b.next_(q, m);
+            }
+            const size_t k = std::min(n, m);
+            if (memcmp(p, q, k) != 0)
+            {
+                return false;
+            }
+            p += k;
+            q += k;
+            n -= k;
+            m -= k;
+        }
+    }
+
+    BTreeRope substr(size_t pos, size_t n = npos) const
+    {
+        const size_t to = pos + std::min(n, m_size - pos);
+        const size_t tree = m_size - (m_tail ? m_tail->count : 0);
+        BTreeRope sliced;
+        if (pos < to and pos < tree)
+        {
+            sliced.m_root = slice_(m_root, pos, std::min(to, tree));
+        }
+        if (pos < to and to > tree)
+        {
+            sliced.m_tail = static_cast<leaf*>(slice_(m_tail, pos > tree ? pos - tree : 0, to - tree));
+        }
+        sliced.m_size = to - pos;
+        return sliced;
+    }
+
+    /**
+     * Copies the size() characters to out.
+     */
+    void flatten_(char* out) const
+    {
+        cursor c(*this);
+        const char* s;
+        size_t n;
+        while (c.next_(s, n))
+        {
+            memcpy(out, s, n);
+            out += n;
+        }
+    }
+
+    inline size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    struct node
+    {
+        unsigned refs;
+        bool branch;
+        unsigned short count; // characters of a leaf, children of a branch.
+
+        explicit node(bool branch_) : refs(1), branch(branch_), count(0)
+        {
+        }
+    };
+
+    struct alignas(64) leaf : node
+    {
+        static const size_t chunk = 64 - sizeof(node);
+
+        char bytes[chunk];
+
+        leaf() : node(false)
+        {
+        }
+    };
+
+    struct branch : node
+    {
+        static const size_t fanout = 16;
+
+        size_t length;
+        size_t lengths[fanout];
+        node* children[fanout];
+
+        branch() : node(true), length(0)
+        {
+        }
+
+        inline void add_(node* child)
+        {
+            children[count] = child;
+            length += lengths[count++] = length_(child);
+        }
+    };
+
+    /**
+     * The leaves in order, tail included.
+     */
+    class cursor
+    {
+    public:
+        explicit cursor(const BTreeRope& rope) : m_depth(0), m_leaf(0), m_tail(rope.m_tail)
+        {
+            descend_(rope.m_root);
+        }
+
+        /**
+         * The characters of the next leaf, false past the last one.
+         */
+        bool next_(const char*& s, size_t& n)
+        {
+            if (m_leaf == 0)
+            {
+                return false;
+            }
+            s = m_leaf->bytes;
+            n = m_leaf->count;
+            while (m_depth and m_index[m_depth - 1] == m_path[m_depth - 1]->count)
+            {
+                --m_depth;
+            }
+            descend_(m_depth ? m_path[m_depth - 1]->children[m_index[m_depth - 1]++] : 0);
+            return true;
+        }
+
+    private:
+        void descend_(const node* at)
+        {
+            for (; at and at->branch; ++m_depth)
+            {
+                m_path[m_depth] = static_cast<const branch*>(at);
+                m_index[m_depth] = 1;
+                at = m_path[m_depth]->children[0];
+            }
+            m_leaf = static_cast<const leaf*>(at);
+            if (m_leaf == 0)
+            {
+                m_leaf = m_tail;
+                m_tail = 0;
+            }
+        }
+
+        const branch* m_path[64]; // branches have two children or more, but on the right edge.
+        unsigned short m_index[64];
+        size_t m_depth;
+        const leaf* m_leaf;
+        const leaf* m_tail;
+    };
+
+    static inline size_t length_(const node* at)
+    {
+        return at->branch ? static_cast<const branch*>(at)->length : at->count;
+    }
+
+    template<typename N>
+    static inline N* ref_(N* at)
+    {
+        if (at)
+        {
+            ++at->refs;
+        }
+        return at;
+    }
+
+    static void unref_(node* at)
+    {
+        if (at == 0 or --at->refs)
+        {
+            return;
+        }
+        if (at->branch)
+        {
+            branch* const b = static_cast<branch*>(at);
+            for (unsigned short i = 0; i < b->count; ++i)
+            {
+                unref_(b->children[i]);
+            }
+            delete b;
+        }
+        else
+        {
+            delete static_cast<leaf*>(at);
+        }
+    }
+
+    /**
+     * The branch itself when not shared, a copy otherwise.
+     */
+    static branch* own_(node* at)
+    {
+        branch* b = static_cast<branch*>(at);
+        if (b->refs > 1)
+        {
+            b = new branch(*b);
+            b->refs = 1;
+            for (unsigned short i = 0; i < b->count; ++i)
+            {
+                ref_(b->children[i]);
+            }
+            unref_(at);
+        }
+        return b;
+    }
+
+    /**
+     * Appends the full tail leaf to the tree.
+     */
+    void push_(leaf* full)
+    {
+        node* overflow = 0;
+        m_root = m_root ? push_(m_root, full, overflow) : full;
+        if (overflow)
+        {
+            branch* const root = new branch;
+            root->add_(m_root);
+            root->add_(overflow);
+            m_root = root;
+        }
+    }
+
+    /**
+     * Adds l at the right edge below at, overflow is set to a sibling of at when at is full.
+     */
+    static node* push_(node* at, leaf* l, node*& overflow)
+    {
+        if (not at->branch)
+        {
+            overflow = l;
+            return at;
+        }
+        branch* const b = own_(at);
+        node* up = 0;
+        const unsigned short last = b->count - 1;
+        b->children[last] = push_(b->children[last], l, up);
+        b->length -= b->lengths[last];
+        b->length += b->lengths[last] = length_(b->children[last]);
+        if (up)
+        {
+            if (b->count < branch::fanout)
+            {
+                b->add_(up);
+            }
+            else
+            {
+                branch* const sibling = new branch;
+                sibling->add_(up);
+                overflow = sibling;
+            }
+        }
+        return b;
+    }
+
+    /**
+     * The characters [from, to) of the tree at, 0 <= from < to <= length_(at).
+     */
+    static node* slice_(node* at, size_t from, size_t to)
+    {
+        if (from == 0 and to == length_(at))
+        {
+            return ref_(at);
+        }
+        if (not at->branch)
+        {
+            leaf* const l = new leaf;
+            memcpy(l->bytes, static_cast<leaf*>(at)->bytes + from, to - from);
+            l->count = to - from;
+            return l;
+        }
+        branch* const b = static_cast<branch*>(at);
+        unsigned short i = 0;
+        size_t offset = 0;
+        for (; offset + b->lengths[i] <= from; offset += b->lengths[i++])
+        {
+        }
+        if (to <= offset + b->lengths[i])
+        {
+            return slice_(b->children[i], from - offset, to - offset);
+        }
+        branch* const sliced = new branch;
+        for (; offset < to; offset += b->lengths[i++])
+        {
+            sliced->add_(slice_(b->children[i], from > offset ? from - offset : 0, std::min(to - offset, b->lengths[i])));
+        }
+        return sliced;
+    }
+
+    node* m_root; // full leaves, and the edges of slices.
+    leaf* m_tail; // the leaf being filled.
+    size_t m_size;
+};
@@ -0,0 +1,123 @@
+/**
+ * Small strings with an inline buffer of N bytes.
+ *
+ * Strings of up to N bytes live in the object itself, longer ones on the
+ * heap, with capacity doubling as they grow. std::string keeps 15 bytes
+ * inline and const_string's buffer_size is fixed per program: building
+ * every benchmark for several N (small-string-N) sweeps the threshold
+ * against the record lengths of the corpus.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+template<size_t N>
+class SmallString
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    SmallString() : m_data(m_inline), m_size(0), m_capacity(N)
+    {
+    }
+
+    SmallString(const char* s, size_t n) : m_data(m_inline), m_size(0), m_capacity(N)
+    {
+        assign(s, n);
+    }
+
+    SmallString(const SmallString& other) : m_data(m_inline), m_size(0), m_capacity(N)
+    {
+        assign(other.m_data, other.m_size);
+    }
+
+    ~SmallString()
+    {
+        if (m_data != m_inline)
+        {
+            free(m_data);
+        }
+    }
+
+    inline SmallString& operator=(const SmallString& other)
+    {
+        if (this != &other)
+        {
+            assign(other.m_data, other.m_size);
+        }
+        return *this;
+    }
+
+    inline void assign(const char* s, size_t n)
+    {
+        if (n > m_capacity)
+        {
+            reserve_(n, false);
+        }
+        memcpy(m_data, s, n);
+        m_size = n;
+    }
+
+    inline void append(const char* s, size_t n)
+    {
+        if (m_size + n > m_capacity)
+        {
+            reserve_(std::max(m_size + n, 2 * m_capacity), true);
+        }
+        memcpy(m_data + m_size, s, n);
+        m_size += n;
+    }
+
+    inline bool operator==(const SmallString& other) const
+    {
+        return m_size == other.m_size and memcmp(m_data, other.m_data, m_size) == 0;
+    }
+
+    inline SmallString substr(size_t pos, size_t n = npos) const
+    {
+        return SmallString(m_data + pos, std::min(n, m_size - pos));
+    }
+
+    inline const char* data() const
+    {
+        return m_data;
+    }
+
+    inline size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    /**
+     * Moves to a heap buffer of capacity bytes, keeping the characters when asked to.
+     */
+    void reserve_(size_t capacity, bool keep)
+    {
+        char* data;
+        if (m_data != m_inline)
+        {
+            data = static_cast<char*>(keep ? realloc(m_data, capacity) : malloc(capacity));
+            if (data and not keep)
+            {
+                free(m_data);
+            }
+        }
+        else if ((data = static_cast<char*>(malloc(capacity))) and keep)
+        {
+            memcpy(data, m_inline, m_size);
+        }
+        if (data == 0)
+        {
+            exit(ENOMEM);
+        }
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    char* m_data; // m_inline, or the heap.
+    size_t m_size;
+    size_t m_capacity;
+    char m_inline[N];
+};
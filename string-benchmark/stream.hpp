@@ -0,0 +1,193 @@
+/**
+ * Streaming string acquisition, for pipes and corpora larger than memory.
+ *
+ * The stream is read in large chunks into three buffers used in turn:
+ * while the records of one are processed, the next chunk is read into
+ * another, by a reader thread unless --reader-thread=no, and the previous
+ * chunk is left untouched, so that records of it (the one before the
+ * first of a chunk) can still be referred to. The incomplete record at
+ * the end of a chunk is carried over to the front of the next one.
+ *
+ * Everything read can be copied to a spill file, so that the input can be
+ * mapped and read again for the following iterations.
+ */
+#include <pthread.h>
+
+namespace benchmark
+{
+
+class stream
+{
+public:
+    stream(int fd, size_t capacity, bool threaded, int spill)
+        : m_fd(fd), m_spill(spill), m_threaded(threaded), m_pending(false), m_eof(false), m_last('\0'), m_next(0)
+    {
+        for (int i = 0; i < buffers; ++i)
+        {
+            m_buffers[i].self = this;
+            m_buffers[i].capacity = capacity;
+            m_buffers[i].length = 0;
+            m_buffers[i].data = static_cast<char*>(malloc(capacity + 1)); // room for a missing final NUL.
+            if (m_buffers[i].data == 0)
+            {
+                exit(ENOMEM);
+            }
+        }
+        launch_(m_buffers[0]);
+    }
+
+    /**
+     * The complete records of the next chunk, false once the stream is exhausted.
+     */
+    bool next_(char*& begin, char*& end)
+    {
+        buffer& current = m_buffers[m_next];
+        wait_();
+
+        char* complete = static_cast<char*>(memrchr(current.data, '\0', current.length));
+        while (not complete and not m_eof)
+        {
+            // a record longer than the buffer, make room and keep reading.
+            current.capacity *= 2;
+            if ((current.data = static_cast<char*>(realloc(current.data, current.capacity + 1))) == 0)
+            {
+                exit(ENOMEM);
+            }
+            fill_(current);
+            complete = static_cast<char*>(memrchr(current.data, '\0', current.length));
+        }
+        if (m_eof and current.length != 0 and current.data[current.length - 1] != '\0')
+        {
+            complete = current.data + current.length; // the last record of a stream needs no NUL.
+            current.data[current.length++] = '\0';
+        }
+        if (not complete)
+        {
+            return false; // nothing left.
+        }
+        complete += 1;
+
+        // carry the incomplete record over and read on behind it.
+        m_next = (m_next + 1) % buffers;
+        buffer& following = m_buffers[m_next];
+        const size_t carry = current.data + current.length - complete;
+        if (carry > following.capacity / 2)
+        {
+            following.capacity = 2 * carry;
+            if ((following.data = static_cast<char*>(realloc(following.data, following.capacity + 1))) == 0)
+            {
+                exit(ENOMEM);
+            }
+        }
+        memcpy(following.data, complete, carry);
+        following.length = carry;
+        launch_(following);
+
+        begin = current.data;
+        end = complete;
+        return true;
+    }
+
+    ~stream()
+    {
+        wait_();
+        for (int i = 0; i < buffers; ++i)
+        {
+            free(m_buffers[i].data);
+        }
+    }
+
+private:
+    stream(const stream&);
+    stream& operator=(const stream&);
+
+    enum { buffers = 3 };
+
+    struct buffer
+    {
+        stream* self;
+        char* data;
+        size_t capacity;
+        size_t length;
+    };
+
+    static void* start(void* b)
+    {
+        buffer& target = *static_cast<buffer*>(b);
+        target.self->fill_(target);
+        return 0;
+    }
+
+    /**
+     * Reads until the buffer is full or the stream ends, copying to the spill file.
+     */
+    void fill_(buffer& target)
+    {
+        while (not m_eof and target.length < target.capacity)
+        {
+            const ssize_t count = read(m_fd, target.data + target.length, target.capacity - target.length);
+            if (count == -1 and errno == EINTR)
+            {
+                continue;
+            }
+            if (count == -1)
+            {
+                exit(errno);
+            }
+            if (count == 0)
+            {
+                m_eof = true;
+                if (m_spill != -1 and m_last != '\0' and write(m_spill, "", 1) != 1)
+                {
+                    exit(errno); // so that the spill file ends with a NUL.
+                }
+                break;
+            }
+            if (m_spill != -1 and write(m_spill, target.data + target.length, count) != count)
+            {
+                exit(errno);
+            }
+            m_last = target.data[target.length + count - 1];
+            target.length += count;
+        }
+    }
+
+    void launch_(buffer& target)
+    {
+        if (m_eof)
+        {
+            return;
+        }
+        if (not m_threaded)
+        {
+            fill_(target);
+            return;
+        }
+        if (pthread_create(&m_reader, 0, &start, &target) != 0)
+        {
+            exit(EAGAIN);
+        }
+        m_pending = true;
+    }
+
+    void wait_()
+    {
+        if (m_pending)
+        {
+            pthread_join(m_reader, 0);
+            m_pending = false;
+        }
+    }
+
+    buffer m_buffers[buffers];
+    pthread_t m_reader;
+    const int m_fd;
+    const int m_spill;
+    const bool m_threaded;
+    bool m_pending;
+    bool m_eof;
+    char m_last;
+    int m_next; // buffer holding (or about to hold) the next chunk.
+};
+
+} // benchmark namespace
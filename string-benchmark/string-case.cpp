@@ -0,0 +1,330 @@
+#include "config.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef USE_CASE_REFERENCE
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "reference"
+#endif // USE_CASE_REFERENCE
+
+/**
+ * ASCII case folding.
+ *
+ * Every record is compared case insensitively with the lower case copy
+ * made of the previous one, the result is the number of equal records.
+ * Immutable strings are lowered through a buffer. The case-reference
+ * program folds the mapped records 32 (AVX2) or 16 (SSE2) bytes at a
+ * time and compares them with memcmp().
+ */
+
+inline char ascii_lower(char c)
+{
+    return (c >= 'A' and c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+inline bool ascii_caseless(char a, char b)
+{
+    return ascii_lower(a) == ascii_lower(b);
+}
+
+/**
+ * Lower case copy of str.
+ */
+template<typename T>
+inline T lower(const T& str, std::vector<char>& buffer)
+{
+    buffer.resize(str.size() + 1);
+    std::transform(str.begin(), str.end(), buffer.begin(), ascii_lower);
+    return benchmark::make<T>(&buffer.front(), str.size());
+}
+
+template<typename T>
+inline bool caseless(const T& a, const T& b)
+{
+    return a.size() == b.size() and std::equal(a.begin(), a.end(), b.begin(), ascii_caseless);
+}
+
+#if defined(USE_STD_STRING) or defined(USE_STD_STRING_GC)
+/**
+ * std::transform() in place.
+ */
+template<>
+inline STR lower<STR>(const STR& str, std::vector<char>&)
+{
+    STR lowered(str);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), ascii_lower);
+    return lowered;
+}
+#endif // USE_STD_STRING or USE_STD_STRING_GC
+
+#ifdef USE_BSTRLIB
+/**
+ * btolower() and biseqcaseless().
+ */
+template<>
+inline STR lower<STR>(const STR& str, std::vector<char>&)
+{
+    STR lowered(str);
+    lowered.tolower();
+    return lowered;
+}
+
+template<>
+inline bool caseless<STR>(const STR& a, const STR& b)
+{
+    return biseqcaseless(&a, &b) == 1;
+}
+#endif // USE_BSTRLIB
+
+#ifdef USE_QT4_STRING
+template<>
+inline STR lower<STR>(const STR& str, std::vector<char>&)
+{
+    return str.toLower();
+}
+
+template<>
+inline bool caseless<STR>(const STR& a, const STR& b)
+{
+    return a.compare(b, Qt::CaseInsensitive) == 0;
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_NOTHING
+template<>
+inline STR lower<STR>(const STR& str, std::vector<char>&)
+{
+    return str;
+}
+
+template<>
+inline bool caseless<STR>(const STR&, const STR&)
+{
+    return false;
+}
+#endif // USE_NOTHING
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+unsigned long lowercase(benchmark::input& input)
+{
+    unsigned long equal = 0;
+    std::vector<char> buffer;
+    T prev(benchmark::construct<T>());
+
+    size_t length;
+    const char* const before = input.preceding_(1, length);
+    if (before)
+    {
+        prev = lower(benchmark::make<T>(before, length), buffer);
+    }
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        T str(benchmark::make<T>(s, n));
+        if (caseless(str, prev))
+        {
+            ++equal;
+        }
+        prev = lower(str, buffer);
+    }
+
+    return equal;
+}
+
+#ifdef USE_CASE_REFERENCE
+/**
+ * Lower case copy of [s, s + n) into out.
+ */
+inline void fold(const char* s, size_t n, char* out)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i before_a = _mm256_set1_epi8('A' - 1);
+    const __m256i after_z = _mm256_set1_epi8('Z' + 1);
+    const __m256i bit = _mm256_set1_epi8('a' - 'A');
+    for (; n - i >= 32; i += 32)
+    {
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(c, before_a), _mm256_cmpgt_epi8(after_z, c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(c, _mm256_and_si256(upper, bit)));
+    }
+#elif defined(__SSE2__)
+    const __m128i before_a = _mm_set1_epi8('A' - 1);
+    const __m128i after_z = _mm_set1_epi8('Z' + 1);
+    const __m128i bit = _mm_set1_epi8('a' - 'A');
+    for (; n - i >= 16; i += 16)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, before_a), _mm_cmpgt_epi8(after_z, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(c, _mm_and_si128(upper, bit)));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        out[i] = ascii_lower(s[i]);
+    }
+}
+
+/**
+ * The reference: no string type, lower case copies in two reused buffers.
+ */
+static unsigned long reference(benchmark::input& input)
+{
+    unsigned long equal = 0;
+    std::vector<char> cur(1), prev(1);
+    size_t length;
+    const char* const before = input.preceding_(1, length);
+    if (before)
+    {
+        prev.resize(length + 1);
+        fold(before, length, &prev.front());
+    }
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        if (cur.end() - cur.begin() < static_cast<ptrdiff_t>(n))
+        {
+            cur.resize(n);
+        }
+        fold(s, n, &cur.front());
+        if (n == length and memcmp(&cur.front(), &prev.front(), n) == 0)
+        {
+            ++equal;
+        }
+        cur.swap(prev);
+        length = n;
+    }
+
+    return equal;
+}
+#endif // USE_CASE_REFERENCE
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, str.lower() and ==.
+ */
+template<>
+unsigned long lowercase<PyStringObject>(benchmark::input& input)
+{
+    unsigned long equal = 0;
+    PyObject* prev = PyString_FromStringAndSize("", 0);
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        PyObject* lowered = PyObject_CallMethod(str, const_cast<char*>("lower"), NULL);
+        if (lowered == NULL)
+        {
+            exit(ECANCELED);
+        }
+        if (_PyString_Eq(lowered, prev))
+        {
+            ++equal;
+        }
+        Py_DECREF(prev);
+        prev = lowered;
+        Py_DECREF(str);
+    }
+    Py_DECREF(prev);
+
+    return equal;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, lc($str) eq $prev with the byte semantics of lc().
+ */
+template<>
+unsigned long lowercase<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    unsigned long equal = 0;
+    SV* prev = newSVpvn("", 0);
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        SV* str = newSVpvn(s, n);
+        SV* lowered = newSVsv(str);
+        for (char* c = SvPVX(lowered), * const end = c + SvCUR(lowered); c != end; ++c)
+        {
+            *c = toLOWER(*c);
+        }
+        if (sv_eq(lowered, prev))
+        {
+            ++equal;
+        }
+        SvREFCNT_dec(prev);
+        prev = lowered;
+        SvREFCNT_dec(str);
+    }
+    SvREFCNT_dec(prev);
+
+    return equal;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization, lowered into a new flat cord.
+ */
+template<>
+unsigned long lowercase<CORD>(benchmark::input& input)
+{
+    unsigned long equal = 0;
+    CORD prev = CORD_EMPTY;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        CORD str = benchmark::cord(s, n);
+        CORD lowered = CORD_EMPTY;
+        if (n != 0)
+        {
+            char* const buffer = static_cast<char*>(GC_MALLOC_ATOMIC(n + 1));
+            if (buffer == 0)
+            {
+                exit(ENOMEM);
+            }
+            const char* const flat = CORD_to_const_char_star(str);
+            std::transform(flat, flat + n, buffer, ascii_lower);
+            buffer[n] = '\0';
+            lowered = buffer;
+        }
+        if (CORD_cmp(lowered, prev) == 0)
+        {
+            ++equal;
+        }
+        prev = lowered;
+    }
+
+    return equal;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("case")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "case");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+#ifdef USE_CASE_REFERENCE
+        const unsigned long equal = benchmark::run(input, threads, reference);
+#else // String type
+        const unsigned long equal = benchmark::run(input, threads, lowercase<STR>);
+#endif // USE_CASE_REFERENCE
+        timing.stop_(i_);
+        printf( "case: %lu equal.\n", equal);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -12,16 +12,34 @@
 template<typename T>
 unsigned long cat(benchmark::input& input)
 {
-    T res;
+    T res(benchmark::construct<T>());
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        res += s;
+        benchmark::append(res, s, n);
     }
 
     return res.size();
 }
 
+#ifdef USE_STRING_VIEW
+/**
+ * String view specialization, the owning fallback: the records are appended to a std::string.
+ */
+template<>
+unsigned long cat<STR>(benchmark::input& input)
+{
+    std::string res;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        res.append(s, n);
+    }
+
+    return res.size();
+}
+#endif // USE_STRING_VIEW
+
 #ifdef USE_PYTHON_STRING
 /**
  * There's probably some BUGS here. But heh be fair to Python.
@@ -86,9 +104,9 @@ unsigned long cat<PyStringObject>(benchmark::input& input)
 {
     PyObject* res = PyString_FromStringAndSize("", 0);
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        PyObject* ns = PyString_FromString(s);
+        PyObject* ns = PyString_FromStringAndSize(s, n);
         if ((res = string_concatenate(res, ns)) == NULL)
         {
             exit(ECANCELED);
@@ -112,9 +130,9 @@ unsigned long cat<SV>(benchmark::input& input)
 
     SV* res = newSV(0);
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        sv_catpv(res, s);
+        sv_catpvn(res, s, n);
     }
     STRLEN result = SvCUR(res);
     SvREFCNT_dec(res);
@@ -131,23 +149,28 @@ unsigned long cat<CORD>(benchmark::input& input)
 {
     CORD res = CORD_EMPTY;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        res = CORD_cat(res, CORD_from_char_star(s));
+        res = CORD_cat(res, benchmark::cord(s, n));
     }
 
     return CORD_len(res);
 }
 #endif // USE_GC_CORD
 
-int main(int argc, char* argv[])
+BENCHMARK_MAIN("cat")
 {
     BENCHMARK_INIT;
     BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
     BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "cat");
     BENCHMARK_ITERATE(input, iterations)
     {
-        printf( "cat: %lu bytes.\n", cat<STR>(input));
+        timing.start_();
+        const unsigned long bytes = benchmark::run(input, threads, cat<STR>);
+        timing.stop_(i_);
+        printf( "cat: %lu bytes.\n", bytes);
     }
     BENCHMARK_FINISH;
     return 0;
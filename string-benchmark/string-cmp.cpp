@@ -9,11 +9,18 @@
 template<typename T>
 void cmp(benchmark::input& input)
 {
-    T cur, prev;
+    T cur(benchmark::construct<T>()), prev(benchmark::construct<T>());
 
-    BENCHMARK_FOREACH(s)
+    size_t length;
+    const char* const before = input.preceding_(1, length);
+    if (before)
     {
-        cur = s;
+        benchmark::assign(prev, before, length);
+    }
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        benchmark::assign(cur, s, n);
         PUTCHAR('0' + (cur == prev));
         PUTCHAR('\n');
 
@@ -30,9 +37,9 @@ void cmp<PyStringObject>(benchmark::input& input)
 {
     PyObject *prev = PyString_FromStringAndSize("", 0);
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        PyObject *cur = PyString_FromString(s);
+        PyObject *cur = PyString_FromStringAndSize(s, n);
         PUTCHAR('0' + _PyString_Eq(cur, prev));
         PUTCHAR('\n');
         Py_DECREF(prev);
@@ -146,9 +153,9 @@ void cmp<SV>(benchmark::input& input)
 
     SV* prev = newSV(0);
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        SV* cur = newSVpv(s, 0);
+        SV* cur = newSVpvn(s, n);
         PUTCHAR('0' + Perl_sv_eq_flags(aTHX_ cur, prev, SV_GMAGIC));
         PUTCHAR('\n');
         SvREFCNT_dec(prev);
@@ -167,9 +174,9 @@ void cmp<CORD>(benchmark::input& input)
 {
     CORD prev = CORD_EMPTY;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        CORD cur = CORD_from_char_star(s);
+        CORD cur = benchmark::cord(s, n);
 
         PUTCHAR('0' + (CORD_cmp(cur, prev) == 0));
         PUTCHAR('\n');
@@ -179,14 +186,18 @@ void cmp<CORD>(benchmark::input& input)
 }
 #endif // USE_GC_CORD
 
-int main(int argc, char* argv[])
+BENCHMARK_MAIN("cmp")
 {
     BENCHMARK_INIT;
     BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
     BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "cmp");
     BENCHMARK_ITERATE(input, iterations)
     {
-        cmp<STR>(input);
+        timing.start_();
+        benchmark::run(input, threads, cmp<STR>);
+        timing.stop_(i_);
     }
     BENCHMARK_FINISH;
     return 0;
@@ -0,0 +1,196 @@
+#include "config.hpp"
+
+/**
+ * Three-way comparison.
+ *
+ * Every record is ordered against the previous one, the result is the
+ * number of records less than, equal to and greater than their
+ * predecessor. Unlike equality (string-cmp), which most implementations
+ * decide on the lengths alone when they differ, ordering has to scan the
+ * shared prefix, and paths share long ones. With --threads every shard
+ * starts from the record before it, as for string-cmp.
+ */
+struct tally
+{
+    unsigned long less;
+    unsigned long equal;
+    unsigned long greater;
+
+    tally() : less(0), equal(0), greater(0)
+    {
+    }
+
+    inline tally& operator+=(const tally& other)
+    {
+        less += other.less;
+        equal += other.equal;
+        greater += other.greater;
+        return *this;
+    }
+
+    inline void add_(int order)
+    {
+        if (order < 0)
+        {
+            ++less;
+        }
+        else if (order > 0)
+        {
+            ++greater;
+        }
+        else
+        {
+            ++equal;
+        }
+    }
+};
+
+/**
+ * Negative, zero or positive as a is less than, equal to or greater than b.
+ */
+template<typename T>
+inline int order(const T& a, const T& b)
+{
+    return a.compare(b);
+}
+
+#ifdef USE_BSTRLIB
+/**
+ * bstrcmp().
+ */
+template<>
+inline int order<STR>(const STR& a, const STR& b)
+{
+    return bstrcmp(&a, &b);
+}
+#endif // USE_BSTRLIB
+
+#ifdef USE_QT4_STRING
+template<>
+inline int order<STR>(const STR& a, const STR& b)
+{
+    return QString::compare(a, b);
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_NOTHING
+template<>
+inline int order<STR>(const STR&, const STR&)
+{
+    return 0;
+}
+#endif // USE_NOTHING
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+tally compare(benchmark::input& input)
+{
+    T cur(benchmark::construct<T>()), prev(benchmark::construct<T>());
+    tally result;
+
+    size_t length;
+    const char* const before = input.preceding_(1, length);
+    if (before)
+    {
+        benchmark::assign(prev, before, length);
+    }
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        benchmark::assign(cur, s, n);
+        result.add_(order(cur, prev));
+
+        prev = cur;
+    }
+
+    return result;
+}
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, cmp(cur, prev).
+ */
+template<>
+tally compare<PyStringObject>(benchmark::input& input)
+{
+    PyObject *prev = PyString_FromStringAndSize("", 0);
+    tally result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject *cur = PyString_FromStringAndSize(s, n);
+        result.add_(PyObject_Compare(cur, prev));
+        Py_DECREF(prev);
+        prev = cur;
+    }
+    Py_DECREF(prev);
+
+    return result;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, $cur cmp $prev.
+ */
+template<>
+tally compare<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    SV* prev = newSVpvs("");
+    tally result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        SV* cur = newSVpvn(s, n);
+        result.add_(sv_cmp(cur, prev));
+        SvREFCNT_dec(prev);
+        prev = cur;
+    }
+    SvREFCNT_dec(prev);
+
+    return result;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization.
+ */
+template<>
+tally compare<CORD>(benchmark::input& input)
+{
+    CORD prev = CORD_EMPTY;
+    tally result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        CORD cur = benchmark::cord(s, n);
+        result.add_(CORD_cmp(cur, prev));
+        prev = cur;
+    }
+
+    return result;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("compare")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "compare");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const tally result = benchmark::run(input, threads, compare<STR>);
+        timing.stop_(i_);
+        printf( "compare: %lu less, %lu equal, %lu greater.\n", result.less, result.equal, result.greater);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "config.hpp"
+
+#include <algorithm>
+
+/**
+ * Substring search.
+ *
+ * The pattern searched in each record is cut from the previous one, at an
+ * offset given by the length of the one before: in paths it is often a
+ * shared directory (a hit), otherwise a miss that scans the whole record.
+ */
+static const size_t pattern_length = 8;
+
+/**
+ * Where the pattern cut from a record of n bytes starts, and its length.
+ */
+inline void pattern(size_t n, size_t ante, size_t& from, size_t& length)
+{
+    from = n ? ante % n : 0;
+    length = std::min(pattern_length, n - from);
+}
+
+/**
+ * Whether needle occurs in str.
+ */
+template<typename T>
+inline bool found(const T& str, const T& needle)
+{
+    return str.find(needle) != T::npos;
+}
+
+#ifdef USE_EXT_ROPE
+template<>
+inline bool found<STR>(const STR& str, const STR& needle)
+{
+    return str.find(needle.c_str()) != STR::npos;
+}
+#endif // USE_EXT_ROPE
+
+#ifdef USE_BSTRLIB
+/**
+ * binstr(), brute force.
+ */
+template<>
+inline bool found<STR>(const STR& str, const STR& needle)
+{
+    return str.find(needle) != BSTR_ERR;
+}
+#endif // USE_BSTRLIB
+
+#ifdef USE_QT4_STRING
+template<>
+inline bool found<STR>(const STR& str, const STR& needle)
+{
+    return str.indexOf(needle) != -1;
+}
+#endif // USE_QT4_STRING
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+unsigned long find(benchmark::input& input)
+{
+    unsigned long hits = 0;
+    size_t ante = 0;
+    T needle;
+    bool searching = false; // the first record has no pattern.
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        T str(benchmark::make<T>(s, n));
+
+        if (searching and found(str, needle))
+        {
+            ++hits;
+        }
+
+        size_t from, length;
+        pattern(n, ante, from, length);
+        benchmark::assign(needle, s + from, length);
+        searching = (length != 0);
+        ante = n;
+    }
+
+    return hits;
+}
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, the "in" operator.
+ */
+template<>
+unsigned long find<PyStringObject>(benchmark::input& input)
+{
+    unsigned long hits = 0;
+    size_t ante = 0;
+    PyObject* needle = 0;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+
+        if (needle and PySequence_Contains(str, needle) == 1)
+        {
+            ++hits;
+        }
+        Py_XDECREF(needle);
+
+        size_t from, length;
+        pattern(n, ante, from, length);
+        needle = length ? PyString_FromStringAndSize(s + from, length) : 0;
+        ante = n;
+
+        Py_DECREF(str);
+    }
+    Py_XDECREF(needle);
+
+    return hits;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, ninstr() as in index() with a variable pattern.
+ */
+template<>
+unsigned long find<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    unsigned long hits = 0;
+    size_t ante = 0;
+    SV* const needle = newSV(0);
+    bool searching = false;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        SV* str = newSVpvn(s, n);
+
+        if (searching)
+        {
+            STRLEN big, little;
+            const char* const b = SvPV_const(str, big);
+            const char* const l = SvPV_const(needle, little);
+            if (ninstr(b, b + big, l, l + little))
+            {
+                ++hits;
+            }
+        }
+
+        size_t from, length;
+        pattern(n, ante, from, length);
+        sv_setpvn(needle, s + from, length);
+        searching = (length != 0);
+        ante = n;
+
+        SvREFCNT_dec(str);
+    }
+    SvREFCNT_dec(needle);
+
+    return hits;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization.
+ */
+template<>
+unsigned long find<CORD>(benchmark::input& input)
+{
+    unsigned long hits = 0;
+    size_t ante = 0;
+    CORD needle = CORD_EMPTY;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        CORD str = benchmark::cord(s, n);
+
+        if (needle != CORD_EMPTY and CORD_str(str, 0, needle) != CORD_NOT_FOUND)
+        {
+            ++hits;
+        }
+
+        size_t from, length;
+        pattern(n, ante, from, length);
+        needle = benchmark::cord(s + from, length);
+        ante = n;
+    }
+
+    return hits;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("find")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "find");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const unsigned long hits = benchmark::run(input, threads, find<STR>);
+        timing.stop_(i_);
+        printf( "find: %lu hits.\n", hits);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include "config.hpp"
+
+#include <cstdio>
+#include <vector>
+
+#ifdef USE_CONST_STRING
+#include "boost/const_string/format.hpp"
+#endif // USE_CONST_STRING
+
+#ifdef USE_FORMAT_STREAM
+#include <iomanip>
+#include <sstream>
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "std-string-ostringstream"
+#define FORMATTER format_stream
+#endif // USE_FORMAT_STREAM
+
+#ifdef USE_FORMAT_APPEND
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "bstring-bformata"
+#define FORMATTER format_append
+#endif // USE_FORMAT_APPEND
+
+#ifndef FORMATTER
+#define FORMATTER format<STR>
+#endif // FORMATTER
+
+/**
+ * Formatted string building.
+ *
+ * Every record is formatted into a new string along with a counter and its
+ * length, as a log line "%08lu:%s:%zu", the result is the total length of
+ * the lines. The printf-like implementations start from a size hint and
+ * format again when the output was truncated:
+ *
+ *  format-std-string                 snprintf() into a presized std::string
+ *  format-std-string-ostringstream   a std::ostringstream per line, locale included
+ *  format-bstring                    CBString::format(), bformat()'s retry loop
+ *  format-bstring-bformata           bformata() onto a truncated, reused bstring
+ *  format-yegorushkin-const-string   cs_format() from format.hpp
+ *  format-qt4-string                 QString::arg()
+ *  format-python-string              the % operator
+ *  format-perl-string                sv_catpvf()
+ *  format-gc-cord-dynamic            CORD_sprintf()
+ */
+static const char pattern[] = "%08lu:%.*s:%zu";
+
+/**
+ * Room for the record and both numbers, enough not to format twice.
+ */
+inline size_t hint(size_t n)
+{
+    return n + 32;
+}
+
+/**
+ * The line of record str, through buffer for the types without a printf of their own.
+ */
+template<typename T>
+inline T print(std::vector<char>& buffer, unsigned long counter, const T& str)
+{
+    const int n = str.size();
+    buffer.resize(hint(n));
+    size_t length = snprintf(&buffer.front(), buffer.end() - buffer.begin(), pattern, counter, n, str.c_str(), str.size());
+    if (length >= static_cast<size_t>(buffer.end() - buffer.begin()))
+    {
+        buffer.resize(length + 1);
+        snprintf(&buffer.front(), length + 1, pattern, counter, n, str.c_str(), str.size());
+    }
+    return benchmark::make<T>(&buffer.front(), length);
+}
+
+#if defined(USE_STD_STRING) or defined(USE_STD_STRING_GC)
+/**
+ * snprintf() straight into the string, resized to the hint and then to the line.
+ */
+template<>
+inline STR print<STR>(std::vector<char>&, unsigned long counter, const STR& str)
+{
+    const int n = str.size();
+    STR line(hint(n), '\0');
+    size_t length = snprintf(&line[0], line.size() + 1, pattern, counter, n, str.c_str(), str.size());
+    if (length > line.size())
+    {
+        line.resize(length);
+        snprintf(&line[0], length + 1, pattern, counter, n, str.c_str(), str.size());
+    }
+    line.resize(length);
+    return line;
+}
+#endif // USE_STD_STRING or USE_STD_STRING_GC
+
+#ifdef USE_CONST_STRING
+template<>
+inline STR print<STR>(std::vector<char>&, unsigned long counter, const STR& str)
+{
+    return boost::cs_format(hint(str.size()), pattern, counter, static_cast<int>(str.size()), str.data(), str.size());
+}
+#endif // USE_CONST_STRING
+
+#ifdef USE_BSTRLIB
+/**
+ * CBString::format(), which doubles its buffer from twice the length of the format as bformat() does.
+ */
+template<>
+inline STR print<STR>(std::vector<char>&, unsigned long counter, const STR& str)
+{
+    STR line;
+    line.format(pattern, counter, str.slen, static_cast<const char*>(str), static_cast<size_t>(str.slen));
+    return line;
+}
+#endif // USE_BSTRLIB
+
+#ifdef USE_QT4_STRING
+/**
+ * The three argument QString::arg(), in one pass: chained arg() calls would
+ * substitute the markers found in the record itself.
+ */
+template<>
+inline STR print<STR>(std::vector<char>&, unsigned long counter, const STR& str)
+{
+    static const QString line("%1:%2:%3");
+    return line.arg(QString::number(counter).rightJustified(8, QLatin1Char('0')), str, QString::number(str.size()));
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_NOTHING
+template<>
+inline STR print<STR>(std::vector<char>&, unsigned long, const STR& str)
+{
+    return str;
+}
+#endif // USE_NOTHING
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+unsigned long format(benchmark::input& input)
+{
+    std::vector<char> buffer;
+    unsigned long counter = 0, bytes = 0;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        T str(benchmark::make<T>(s, n));
+        const T line(print(buffer, ++counter, str));
+        bytes += line.size();
+    }
+
+    return bytes;
+}
+
+#ifdef USE_FORMAT_STREAM
+static unsigned long format_stream(benchmark::input& input)
+{
+    unsigned long counter = 0, bytes = 0;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        STR str(benchmark::make<STR>(s, n));
+        std::ostringstream line;
+        line << std::setw(8) << std::setfill('0') << ++counter << ':' << str << ':' << str.size();
+        bytes += line.str().size();
+    }
+
+    return bytes;
+}
+#endif // USE_FORMAT_STREAM
+
+#ifdef USE_FORMAT_APPEND
+static unsigned long format_append(benchmark::input& input)
+{
+    unsigned long counter = 0, bytes = 0;
+    bstring line = bfromcstralloc(hint(0), "");
+    if (line == NULL)
+    {
+        exit(ENOMEM);
+    }
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        STR str(benchmark::make<STR>(s, n));
+        btrunc(line, 0);
+        if (bformata(line, pattern, ++counter, str.slen, static_cast<const char*>(str), static_cast<size_t>(str.slen)) != BSTR_OK)
+        {
+            exit(ENOMEM);
+        }
+        bytes += line->slen;
+    }
+    bdestroy(line);
+
+    return bytes;
+}
+#endif // USE_FORMAT_APPEND
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, '%08lu:%s:%lu' % (counter, str, len(str)).
+ */
+template<>
+unsigned long format<PyStringObject>(benchmark::input& input)
+{
+    unsigned long counter = 0, bytes = 0;
+    PyObject* const line = PyString_FromString("%08lu:%s:%lu");
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        PyObject* args = Py_BuildValue("(kOn)", ++counter, str, PyString_GET_SIZE(str));
+        PyObject* formatted = args ? PyString_Format(line, args) : NULL;
+        if (formatted == NULL)
+        {
+            exit(ECANCELED);
+        }
+        bytes += PyString_GET_SIZE(formatted);
+        Py_DECREF(formatted);
+        Py_DECREF(args);
+        Py_DECREF(str);
+    }
+    Py_DECREF(line);
+
+    return bytes;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, sv_catpvf() as sprintf does.
+ */
+template<>
+unsigned long format<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    unsigned long counter = 0, bytes = 0;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        SV* str = newSVpvn(s, n);
+        SV* line = newSVpvs("");
+        sv_catpvf(line, "%08lu:%" SVf ":%lu", ++counter, SVfARG(str), static_cast<unsigned long>(SvCUR(str)));
+        bytes += SvCUR(line);
+        SvREFCNT_dec(line);
+        SvREFCNT_dec(str);
+    }
+
+    return bytes;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization, CORD_sprintf() and its %r conversion.
+ */
+template<>
+unsigned long format<CORD>(benchmark::input& input)
+{
+    unsigned long counter = 0, bytes = 0;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        CORD str = benchmark::cord(s, n);
+        CORD line;
+        if (CORD_sprintf(&line, "%08lu:%r:%lu", ++counter, str, static_cast<unsigned long>(CORD_len(str))) < 0)
+        {
+            exit(ENOMEM);
+        }
+        bytes += CORD_len(line);
+    }
+
+    return bytes;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("format")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "format");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const unsigned long bytes = benchmark::run(input, threads, FORMATTER);
+        timing.stop_(i_);
+        printf( "format: %lu bytes.\n", bytes);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
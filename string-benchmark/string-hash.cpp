@@ -0,0 +1,139 @@
+#include "config.hpp"
+#include "hashing.hpp"
+
+#include <unordered_set>
+
+#ifdef USE_QT4_STRING
+#include <QSet>
+#endif // USE_QT4_STRING
+
+/**
+ * Hash set insertion.
+ *
+ * Every record is hashed and inserted into a set, the result is the
+ * number of distinct records (per shard with --threads).
+ * Implementations with a hash of their own use it along with their own
+ * container; the others share the common hash of hashing.hpp.
+ */
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+unsigned long hash(benchmark::input& input)
+{
+    std::unordered_set< T, hasher<T>, equal<T> > set;
+    unsigned long distinct = 0; // not set.size(), which bstrlib's size macro renames.
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        distinct += set.insert(benchmark::make<T>(s, n)).second;
+    }
+
+    return distinct;
+}
+
+#ifdef USE_NOTHING
+/**
+ * NullString specialization, the lower bound: no hash, no set.
+ */
+template<>
+unsigned long hash<NullString>(benchmark::input& input)
+{
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        NullString str(benchmark::make<NullString>(s, n));
+    }
+
+    return 0;
+}
+#endif // USE_NOTHING
+
+#ifdef USE_QT4_STRING
+/**
+ * QString specialization, qHash() and QSet.
+ */
+template<>
+unsigned long hash<QString>(benchmark::input& input)
+{
+    QSet<QString> set;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        set.insert(benchmark::make<QString>(s, n));
+    }
+
+    return set.size();
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, a set() using the hash cached in ob_shash.
+ */
+template<>
+unsigned long hash<PyStringObject>(benchmark::input& input)
+{
+    PyObject* set = PySet_New(NULL);
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        if (PySet_Add(set, str) == -1)
+        {
+            exit(ENOMEM);
+        }
+        Py_DECREF(str);
+    }
+
+    const unsigned long result = PySet_Size(set);
+    Py_DECREF(set);
+    return result;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, $seen{$str} with PERL_HASH() computed up front.
+ */
+template<>
+unsigned long hash<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    HV* const set = newHV();
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        SV* str = newSVpvn(s, n);
+        STRLEN length;
+        const char* const key = SvPV_const(str, length);
+        U32 code;
+        PERL_HASH(code, key, length);
+        hv_fetch_ent(set, str, 1, code);
+        SvREFCNT_dec(str);
+    }
+
+    const unsigned long result = HvUSEDKEYS(set);
+    SvREFCNT_dec(set);
+    return result;
+}
+#endif // USE_PERL_STRING
+
+BENCHMARK_MAIN("hash")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "hash");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const unsigned long distinct = benchmark::run(input, threads, hash<STR>);
+        timing.stop_(i_);
+        printf( "hash: %lu distinct.\n", distinct);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -0,0 +1,390 @@
+#include "config.hpp"
+#include "hashing.hpp"
+
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+#include <malloc.h>
+
+#ifdef USE_QT4_STRING
+#include <QSet>
+#endif // USE_QT4_STRING
+
+#ifdef USE_INTERN_REFERENCE
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "reference"
+#endif // USE_INTERN_REFERENCE
+
+/**
+ * Interning.
+ *
+ * Every record is interned into a symbol table, which hands back a stable
+ * handle (an address) kept for the whole run. The result is the number of
+ * symbols, of distinct ones, and the heap the table grew by: bytes in use
+ * as malloc sees them, without the handles themselves. Allocators of their
+ * own (Boehm GC, pymalloc arenas) escape it, and the heap is shared by the
+ * shards, so measure memory single threaded.
+ *
+ *  intern-std-string     std::unordered_set, the handle is the address of the element
+ *  intern-python-string  PyString_InternInPlace()
+ *  intern-perl-string    the shared string table PL_strtab, through newSVpvn_share()
+ *  intern-qt4-string     QSet
+ *  intern-reference      an open addressing table over an arena of copies
+ */
+
+/**
+ * Bytes of heap in use, or 0 without mallinfo2().
+ */
+inline long heap()
+{
+#if defined(__GLIBC__) and (__GLIBC__ > 2 or __GLIBC_MINOR__ >= 33)
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else // No heap statistics
+    return 0;
+#endif
+}
+
+struct symbols
+{
+    unsigned long count;
+    unsigned long distinct;
+    long heap;
+
+    symbols() : count(0), distinct(0), heap(0)
+    {
+    }
+
+    inline symbols& operator+=(const symbols& other)
+    {
+        count += other.count;
+        distinct += other.distinct;
+        heap += other.heap;
+        return *this;
+    }
+};
+
+/**
+ * Heap grown since before, the handles excluded.
+ */
+template<typename H>
+inline long grown(long before, const std::vector<H>& handles)
+{
+    return heap() - before - handles.capacity() * sizeof(H);
+}
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+symbols intern(benchmark::input& input)
+{
+    const long before = heap();
+    std::unordered_set< T, hasher<T>, equal<T> > table;
+    std::vector<const T*> handles;
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        const std::pair<typename std::unordered_set< T, hasher<T>, equal<T> >::iterator, bool> at
+            = table.insert(benchmark::make<T>(s, n));
+        handles.push_back(&*at.first);
+        result.distinct += at.second;
+    }
+
+    result.count = handles.end() - handles.begin();
+    result.heap = grown(before, handles);
+    return result;
+}
+
+#if defined(USE_NOTHING) and not defined(USE_INTERN_REFERENCE)
+/**
+ * NullString specialization, the lower bound: no table.
+ */
+template<>
+symbols intern<NullString>(benchmark::input& input)
+{
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        NullString str(benchmark::make<NullString>(s, n));
+        ++result.count;
+    }
+
+    return result;
+}
+#endif // USE_NOTHING, not the reference
+
+#ifdef USE_INTERN_REFERENCE
+/**
+ * Arena backed interner.
+ *
+ * Every distinct symbol is copied once, NUL terminated, into chunks that
+ * never move, so the copy's address is the handle. A linear probing table
+ * of 16 byte (hash, length, symbol) slots, at most 3/4 full, finds them.
+ */
+class interner
+{
+public:
+    interner() : m_free(0), m_left(0), m_count(0), m_slots(1 << 10)
+    {
+    }
+
+    ~interner()
+    {
+        for (std::vector<char*>::const_iterator chunk = m_chunks.begin(); chunk != m_chunks.end(); ++chunk)
+        {
+            free(*chunk);
+        }
+    }
+
+    /**
+     * The handle of [s, s + n), inserted tells whether it was new.
+     */
+    const char* intern_(const char* s, size_t n, bool& inserted)
+    {
+        const unsigned hash = fnv1a(s, n);
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask)
+        {
+            slot& at = m_slots[i];
+            if (at.symbol == 0)
+            {
+                at.hash = hash;
+                at.length = n;
+                const char* const symbol = at.symbol = copy_(s, n);
+                inserted = true;
+                if (++m_count * 4 > m_slots.size() * 3)
+                {
+                    grow_(); // at is gone.
+                }
+                return symbol;
+            }
+            if (at.hash == hash and at.length == n and memcmp(at.symbol, s, n) == 0)
+            {
+                inserted = false;
+                return at.symbol;
+            }
+        }
+    }
+
+private:
+    struct slot
+    {
+        unsigned hash;
+        unsigned length; // records are shorter than 4G.
+        const char* symbol;
+
+        slot() : hash(0), length(0), symbol(0)
+        {
+        }
+    };
+
+    static const size_t chunk = 64 << 10;
+
+    const char* copy_(const char* s, size_t n)
+    {
+        if (n + 1 > m_left)
+        {
+            m_left = n + 1 > chunk ? n + 1 : chunk;
+            m_free = static_cast<char*>(malloc(m_left));
+            if (m_free == 0)
+            {
+                exit(ENOMEM);
+            }
+            m_chunks.push_back(m_free);
+        }
+        char* const symbol = m_free;
+        memcpy(symbol, s, n);
+        symbol[n] = '\0';
+        m_free += n + 1;
+        m_left -= n + 1;
+        return symbol;
+    }
+
+    void grow_()
+    {
+        std::vector<slot> slots(m_slots.size() * 2);
+        const size_t mask = slots.size() - 1;
+        for (std::vector<slot>::const_iterator at = m_slots.begin(); at != m_slots.end(); ++at)
+        {
+            if (at->symbol)
+            {
+                size_t i = at->hash & mask;
+                while (slots[i].symbol)
+                {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = *at;
+            }
+        }
+        m_slots.swap(slots);
+    }
+
+    std::vector<char*> m_chunks;
+    char* m_free;
+    size_t m_left;
+    size_t m_count;
+    std::vector<slot> m_slots;
+};
+
+/**
+ * The reference: the records are interned straight from the mapping.
+ */
+static symbols reference(benchmark::input& input)
+{
+    const long before = heap();
+    interner table;
+    std::vector<const char*> handles;
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        bool inserted;
+        handles.push_back(table.intern_(s, n, inserted));
+        result.distinct += inserted;
+    }
+
+    result.count = handles.end() - handles.begin();
+    result.heap = grown(before, handles);
+    return result;
+}
+#endif // USE_INTERN_REFERENCE
+
+#ifdef USE_QT4_STRING
+/**
+ * QString specialization, QSet.
+ */
+template<>
+symbols intern<QString>(benchmark::input& input)
+{
+    const long before = heap();
+    QSet<QString> table;
+    std::vector<const QString*> handles;
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        const int had = table.size();
+        handles.push_back(&*table.insert(benchmark::make<QString>(s, n)));
+        result.distinct += table.size() != had;
+    }
+
+    result.count = handles.end() - handles.begin();
+    result.heap = grown(before, handles);
+    return result;
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, PyString_InternInPlace().
+ * Interned strings are mortal: the handles keep them alive.
+ */
+template<>
+symbols intern<PyStringObject>(benchmark::input& input)
+{
+    const long before = heap();
+    std::vector<PyObject*> handles;
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        PyObject* const fresh = str;
+        PyString_InternInPlace(&str);
+        handles.push_back(str);
+        result.distinct += str == fresh;
+    }
+
+    result.count = handles.end() - handles.begin();
+    result.heap = grown(before, handles);
+    for (std::vector<PyObject*>::const_iterator str = handles.begin(); str != handles.end(); ++str)
+    {
+        Py_DECREF(*str);
+    }
+    return result;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, newSVpvn_share() as hash keys are shared:
+ * the handle is the shared HEK of PL_strtab the scalar points into.
+ */
+template<>
+symbols intern<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    const long before = heap();
+    const STRLEN shared = HvTOTALKEYS(PL_strtab);
+    std::vector<SV*> handles;
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        handles.push_back(newSVpvn_share(s, n, 0));
+    }
+
+    result.count = handles.end() - handles.begin();
+    result.distinct = HvTOTALKEYS(PL_strtab) - shared;
+    result.heap = grown(before, handles);
+    for (std::vector<SV*>::const_iterator str = handles.begin(); str != handles.end(); ++str)
+    {
+        SvREFCNT_dec(*str);
+    }
+    return result;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization.
+ */
+template<>
+symbols intern<CORD>(benchmark::input& input)
+{
+    const long before = heap();
+    std::unordered_set< CORD, hasher<CORD>, equal<CORD> > table;
+    std::vector<const CORD*> handles;
+    symbols result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        const std::pair<std::unordered_set< CORD, hasher<CORD>, equal<CORD> >::iterator, bool> at
+            = table.insert(benchmark::cord(s, n));
+        handles.push_back(&*at.first);
+        result.distinct += at.second;
+    }
+
+    result.count = handles.end() - handles.begin();
+    result.heap = grown(before, handles);
+    return result;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("intern")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "intern");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+#ifdef USE_INTERN_REFERENCE
+        const symbols result = benchmark::run(input, threads, reference);
+#else // String type
+        const symbols result = benchmark::run(input, threads, intern<STR>);
+#endif // USE_INTERN_REFERENCE
+        timing.stop_(i_);
+        printf( "intern: %lu symbols, %lu distinct, %ld heap bytes, %.1f per distinct.\n", result.count, result.distinct,
+                result.heap, result.distinct ? double(result.heap) / result.distinct : 0.0);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
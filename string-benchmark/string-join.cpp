@@ -0,0 +1,423 @@
+#include "config.hpp"
+
+#include <cstring>
+#include <vector>
+
+#ifdef USE_CONST_STRING
+// provided for drop in compatibility with std::basic_string<>
+#include "boost/const_string/concatenation.hpp"
+#endif // USE_CONST_STRING
+
+#ifdef USE_QT4_STRING
+#include <QStringList>
+#endif // USE_QT4_STRING
+
+#ifdef USE_JOIN_LIST
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "bstring-list"
+#define JOINER join_list
+#endif // USE_JOIN_LIST
+
+#ifndef JOINER
+#define JOINER join<STR>
+#endif // JOINER
+
+/**
+ * Joining.
+ *
+ * The records are gathered in batches of --batch=K (16 by default), every
+ * batch is joined with ',' into a new string. The result is the number of
+ * joined strings and the sum of their lengths. Small batches show the cost
+ * of a join, large ones that of copying; let benchmark.pl sweep K with
+ * --batch=1,4,16,64. With --threads every shard is batched separately.
+ *
+ *  join-std-string          two passes: the length, then copies into the presized string
+ *  join-bstring             bjoin() of a bstrList
+ *  join-bstring-list        CBString(CBStringList, sep)
+ *  join-qt4-string          QStringList::join()
+ *  join-python-string       ','.join(list)
+ *  join-perl-string         join ',', @list as pp_join does
+ *  join-gc-cord-dynamic     CORD_cat()
+ *  join-ext-rope, join-yegorushkin-const-string  operator+=
+ */
+static const char separator[] = ",";
+static long batch = 16;
+
+struct lines
+{
+    unsigned long count;
+    unsigned long bytes;
+
+    lines() : count(0), bytes(0)
+    {
+    }
+
+    inline lines& operator+=(const lines& other)
+    {
+        count += other.count;
+        bytes += other.bytes;
+        return *this;
+    }
+
+    inline void add_(size_t length)
+    {
+        ++count;
+        bytes += length;
+    }
+};
+
+/**
+ * The pieces, never empty, joined with sep.
+ */
+template<typename T>
+inline T glue(const std::vector<T>& pieces, const T& sep)
+{
+    typename std::vector<T>::const_iterator piece = pieces.begin();
+    T line(*piece);
+    for (++piece; piece != pieces.end(); ++piece)
+    {
+        line += sep;
+        line += *piece;
+    }
+    return line;
+}
+
+#if defined(USE_STD_STRING) or defined(USE_STD_STRING_GC)
+/**
+ * Presize then copy: a single allocation, the string is zero filled first.
+ */
+template<>
+inline STR glue<STR>(const std::vector<STR>& pieces, const STR& sep)
+{
+    size_t length = 0;
+    for (std::vector<STR>::const_iterator piece = pieces.begin(); piece != pieces.end(); ++piece)
+    {
+        length += sep.size() + piece->size();
+    }
+
+    STR line(length - sep.size(), '\0');
+    char* out = &line[0];
+    for (std::vector<STR>::const_iterator piece = pieces.begin(); piece != pieces.end(); ++piece)
+    {
+        if (piece != pieces.begin())
+        {
+            memcpy(out, sep.data(), sep.size());
+            out += sep.size();
+        }
+        memcpy(out, piece->data(), piece->size());
+        out += piece->size();
+    }
+    return line;
+}
+#endif // USE_STD_STRING or USE_STD_STRING_GC
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+lines join(benchmark::input& input)
+{
+    const T sep(benchmark::make<T>(separator, sizeof(separator) - 1));
+    std::vector<T> pieces;
+    pieces.reserve(batch);
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        pieces.push_back(benchmark::make<T>(s, n));
+        if (pieces.end() - pieces.begin() == batch)
+        {
+            result.add_(glue(pieces, sep).size());
+            pieces.clear();
+        }
+    }
+    if (pieces.begin() != pieces.end())
+    {
+        result.add_(glue(pieces, sep).size());
+    }
+
+    return result;
+}
+
+#if defined(USE_BSTRLIB) and not defined(USE_JOIN_LIST)
+/**
+ * bjoin() of the pieces, which are destroyed.
+ */
+inline size_t flush(struct bstrList* pieces, const STR& sep)
+{
+    bstring line = bjoin(pieces, &sep);
+    if (line == 0)
+    {
+        exit(ENOMEM);
+    }
+    const size_t length = line->slen;
+    bdestroy(line);
+    for (; pieces->qty > 0; --pieces->qty)
+    {
+        bdestroy(pieces->entry[pieces->qty - 1]);
+    }
+    return length;
+}
+
+/**
+ * Bstrlib specialization, the batch is gathered in a bstrList.
+ */
+template<>
+lines join<STR>(benchmark::input& input)
+{
+    const STR sep(separator);
+    struct bstrList* const pieces = bstrListCreate();
+    if (pieces == 0 or bstrListAlloc(pieces, batch) != BSTR_OK)
+    {
+        exit(ENOMEM);
+    }
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        pieces->entry[pieces->qty++] = blk2bstr(s, n);
+        if (pieces->qty == batch)
+        {
+            result.add_(flush(pieces, sep));
+        }
+    }
+    if (pieces->qty > 0)
+    {
+        result.add_(flush(pieces, sep));
+    }
+    bstrListDestroy(pieces);
+
+    return result;
+}
+#endif // USE_BSTRLIB, not a variant
+
+#ifdef USE_JOIN_LIST
+static lines join_list(benchmark::input& input)
+{
+    const STR sep(separator);
+    Bstrlib::CBStringList pieces;
+    pieces.reserve(batch);
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        pieces.push_back(benchmark::make<STR>(s, n));
+        if (pieces.end() - pieces.begin() == batch)
+        {
+            result.add_(STR(pieces, sep).slen);
+            pieces.clear();
+        }
+    }
+    if (pieces.begin() != pieces.end())
+    {
+        result.add_(STR(pieces, sep).slen);
+    }
+
+    return result;
+}
+#endif // USE_JOIN_LIST
+
+#ifdef USE_QT4_STRING
+/**
+ * QString specialization, QStringList::join().
+ */
+template<>
+lines join<QString>(benchmark::input& input)
+{
+    const QString sep(separator);
+    QStringList pieces;
+    pieces.reserve(batch);
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        pieces.append(benchmark::make<QString>(s, n));
+        if (pieces.size() == batch)
+        {
+            result.add_(pieces.join(sep).size());
+            pieces.clear();
+        }
+    }
+    if (not pieces.isEmpty())
+    {
+        result.add_(pieces.join(sep).size());
+    }
+
+    return result;
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_PYTHON_STRING
+/**
+ * ','.join(pieces), which sums the lengths first too, and a new list.
+ */
+inline size_t flush(PyObject*& pieces, PyObject* sep)
+{
+    PyObject* line = _PyString_Join(sep, pieces);
+    if (line == NULL)
+    {
+        exit(ECANCELED);
+    }
+    const size_t length = PyString_GET_SIZE(line);
+    Py_DECREF(line);
+    Py_DECREF(pieces);
+    pieces = PyList_New(0);
+    return length;
+}
+
+/**
+ * Python String Object specialization.
+ */
+template<>
+lines join<PyStringObject>(benchmark::input& input)
+{
+    PyObject* const sep = PyString_FromString(separator);
+    PyObject* pieces = PyList_New(0);
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        if (PyList_Append(pieces, str) == -1)
+        {
+            exit(ENOMEM);
+        }
+        Py_DECREF(str);
+        if (PyList_GET_SIZE(pieces) == batch)
+        {
+            result.add_(flush(pieces, sep));
+        }
+    }
+    if (PyList_GET_SIZE(pieces) > 0)
+    {
+        result.add_(flush(pieces, sep));
+    }
+    Py_DECREF(pieces);
+    Py_DECREF(sep);
+
+    return result;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Emulates join ',', @pieces as do_join() does: grows the result once, then appends.
+ * The pieces are cleared.
+ */
+inline size_t flush(pTHX_ AV* pieces)
+{
+    const SSize_t count = AvFILLp(pieces) + 1;
+    STRLEN length = (count - 1) * (sizeof(separator) - 1);
+    for (SSize_t i = 0; i < count; ++i)
+    {
+        length += SvCUR(AvARRAY(pieces)[i]);
+    }
+
+    SV* line = newSV(length);
+    sv_setpvs(line, "");
+    for (SSize_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+        {
+            sv_catpvn(line, separator, sizeof(separator) - 1);
+        }
+        sv_catsv(line, AvARRAY(pieces)[i]);
+    }
+
+    length = SvCUR(line);
+    SvREFCNT_dec(line);
+    av_clear(pieces);
+    return length;
+}
+
+/**
+ * Perl scalar specialization.
+ */
+template<>
+lines join<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    AV* const pieces = newAV();
+    av_extend(pieces, batch - 1);
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        av_push(pieces, newSVpvn(s, n));
+        if (AvFILLp(pieces) + 1 == batch)
+        {
+            result.add_(flush(aTHX_ pieces));
+        }
+    }
+    if (AvFILLp(pieces) >= 0)
+    {
+        result.add_(flush(aTHX_ pieces));
+    }
+    SvREFCNT_dec(pieces);
+
+    return result;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * CORD_cat() of the pieces, which are cleared.
+ */
+inline size_t flush(std::vector<CORD>& pieces)
+{
+    CORD line = pieces.front();
+    for (std::vector<CORD>::const_iterator piece = pieces.begin() + 1; piece != pieces.end(); ++piece)
+    {
+        line = CORD_cat(CORD_cat(line, separator), *piece);
+    }
+    pieces.clear();
+    return CORD_len(line);
+}
+
+/**
+ * GC CORD specialization.
+ */
+template<>
+lines join<CORD>(benchmark::input& input)
+{
+    std::vector<CORD> pieces;
+    pieces.reserve(batch);
+    lines result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        pieces.push_back(benchmark::cord(s, n));
+        if (pieces.end() - pieces.begin() == batch)
+        {
+            result.add_(flush(pieces));
+        }
+    }
+    if (pieces.begin() != pieces.end())
+    {
+        result.add_(flush(pieces));
+    }
+
+    return result;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("join")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "join");
+    const char* const batch_ = benchmark::option(argc, argv, "batch");
+    batch = batch_ ? benchmark::iterations(batch_) : batch;
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const lines result = benchmark::run(input, threads, JOINER);
+        timing.stop_(i_);
+        printf( "join: %lu strings, %lu bytes.\n", result.count, result.bytes);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -9,9 +9,9 @@ unsigned long build(benchmark::input& input)
 {
     unsigned long res = 0;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        T str(s);
+        T str(benchmark::make<T>(s, n));
         res += str.size();
     }
 
@@ -27,9 +27,9 @@ unsigned long build<PyStringObject>(benchmark::input& input)
 {
     unsigned long res = 0;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        PyObject* str = PyString_FromString(s);
+        PyObject* str = PyString_FromStringAndSize(s, n);
         res += PyString_Size(str);
         Py_DECREF(str);
     }
@@ -48,9 +48,9 @@ unsigned long build<SV>(benchmark::input& input)
 
     unsigned long res = 0;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        SV* str = newSVpv(s, 0);
+        SV* str = newSVpvn(s, n);
         res += SvCUR(str);
         SvREFCNT_dec(str);
     }
@@ -67,9 +67,9 @@ unsigned long build<CORD>(benchmark::input& input)
 {
     unsigned long res = 0;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        CORD str = CORD_from_char_star(s);
+        CORD str = benchmark::cord(s, n);
         res += CORD_len(str);
     }
 
@@ -77,14 +77,19 @@ unsigned long build<CORD>(benchmark::input& input)
 }
 #endif // USE_GC_CORD
 
-int main(int argc, char* argv[])
+BENCHMARK_MAIN("new")
 {
     BENCHMARK_INIT;
     BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
     BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "new");
     BENCHMARK_ITERATE(input, iterations)
     {
-        printf( "build: %lu bytes.\n", build<STR>(input));
+        timing.start_();
+        const unsigned long bytes = benchmark::run(input, threads, build<STR>);
+        timing.stop_(i_);
+        printf( "build: %lu bytes.\n", bytes);
     }
     BENCHMARK_FINISH;
     return 0;
@@ -0,0 +1,272 @@
+#include "config.hpp"
+
+#ifdef USE_CONST_STRING
+// provided for drop in compatibility with std::basic_string<>
+#include "boost/const_string/concatenation.hpp"
+#endif // USE_CONST_STRING
+
+#ifdef USE_REPLACE_CASELESS
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "bstring-caseless"
+#define REPLACER replace_caseless
+#endif // USE_REPLACE_CASELESS
+
+#ifndef REPLACER
+#define REPLACER replace<STR>
+#endif // REPLACER
+
+/**
+ * Find and replace.
+ *
+ * Every occurrence of "/usr/" in every record is replaced three times,
+ * each time in a fresh copy of the record: by a longer, a shorter and an
+ * equally long string. The result is the total length of each rewrite.
+ * The replace-bstring-caseless program uses bfindreplacecaseless().
+ */
+static const char pattern[] = "/usr/";
+static const char* const replacements[] = { "/opt/local/", "/", "/opt/" };
+static const int kinds = sizeof(replacements) / sizeof(replacements[0]);
+
+struct lengths
+{
+    unsigned long bytes[kinds]; // grown, shrunk, same
+
+    lengths()
+    {
+        for (int k = 0; k < kinds; ++k)
+        {
+            bytes[k] = 0;
+        }
+    }
+
+    inline lengths& operator+=(const lengths& other)
+    {
+        for (int k = 0; k < kinds; ++k)
+        {
+            bytes[k] += other.bytes[k];
+        }
+        return *this;
+    }
+};
+
+/**
+ * Replaces every occurrence of what in str, left to right.
+ */
+template<typename T>
+inline void replace_all(T& str, const T& what, const T& with)
+{
+    for (size_t pos = str.find(what); pos != T::npos; pos = str.find(what, pos + with.size()))
+    {
+        str.replace(pos, what.size(), with);
+    }
+}
+
+#ifdef USE_EXT_ROPE
+template<>
+inline void replace_all<STR>(STR& str, const STR& what, const STR& with)
+{
+    for (size_t pos = str.find(what.c_str()); pos != STR::npos; pos = str.find(what.c_str(), pos + with.size()))
+    {
+        str.replace(pos, what.size(), with);
+    }
+}
+#endif // USE_EXT_ROPE
+
+#ifdef USE_BSTRLIB
+/**
+ * bfindreplace(), which moves in place when the replacement is not longer.
+ */
+template<>
+inline void replace_all<STR>(STR& str, const STR& what, const STR& with)
+{
+    str.findreplace(what, with);
+}
+#endif // USE_BSTRLIB
+
+#ifdef USE_CONST_STRING
+/**
+ * Immutable, every replacement concatenates a new string.
+ */
+template<>
+inline void replace_all<STR>(STR& str, const STR& what, const STR& with)
+{
+    for (size_t pos = str.find(what); pos != STR::npos; pos = str.find(what, pos + with.size()))
+    {
+        str = STR(str.ref_substr(0, pos) + with + str.ref_substr(pos + what.size()));
+    }
+}
+#endif // USE_CONST_STRING
+
+#ifdef USE_QT4_STRING
+template<>
+inline void replace_all<STR>(STR& str, const STR& what, const STR& with)
+{
+    str.replace(what, with);
+}
+#endif // USE_QT4_STRING
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+lengths replace(benchmark::input& input)
+{
+    const T what(benchmark::make<T>(pattern, sizeof(pattern) - 1));
+    T with[kinds];
+    for (int k = 0; k < kinds; ++k)
+    {
+        benchmark::assign(with[k], replacements[k], strlen(replacements[k]));
+    }
+    lengths result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        for (int k = 0; k < kinds; ++k)
+        {
+            T str(benchmark::make<T>(s, n));
+            replace_all(str, what, with[k]);
+            result.bytes[k] += str.size();
+        }
+    }
+
+    return result;
+}
+
+#ifdef USE_REPLACE_CASELESS
+static lengths replace_caseless(benchmark::input& input)
+{
+    lengths result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        for (int k = 0; k < kinds; ++k)
+        {
+            STR str(benchmark::make<STR>(s, n));
+            str.findreplacecaseless(pattern, replacements[k]);
+            result.bytes[k] += str.slen;
+        }
+    }
+
+    return result;
+}
+#endif // USE_REPLACE_CASELESS
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, str.replace().
+ */
+template<>
+lengths replace<PyStringObject>(benchmark::input& input)
+{
+    lengths result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        for (int k = 0; k < kinds; ++k)
+        {
+            PyObject* replaced = PyObject_CallMethod(str, const_cast<char*>("replace"), const_cast<char*>("ss"),
+                                                     pattern, replacements[k]);
+            if (replaced == NULL)
+            {
+                exit(ECANCELED);
+            }
+            result.bytes[k] += PyString_GET_SIZE(replaced);
+            Py_DECREF(replaced);
+        }
+        Py_DECREF(str);
+    }
+
+    return result;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization.
+ * Emulates s{/usr/}{...}g with a constant pattern: ninstr() and sv_insert().
+ */
+template<>
+lengths replace<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    const STRLEN what = sizeof(pattern) - 1;
+    lengths result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        for (int k = 0; k < kinds; ++k)
+        {
+            SV* str = newSVpvn(s, n);
+            const STRLEN with = strlen(replacements[k]);
+
+            for (STRLEN pos = 0; ; pos += with)
+            {
+                const char* const begin = SvPVX_const(str);
+                const char* const at = ninstr(begin + pos, begin + SvCUR(str), pattern, pattern + what);
+                if (at == NULL)
+                {
+                    break;
+                }
+                pos = at - begin;
+                sv_insert(str, pos, what, replacements[k], with);
+            }
+
+            result.bytes[k] += SvCUR(str);
+            SvREFCNT_dec(str);
+        }
+    }
+
+    return result;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization, CORD_str() and concatenation.
+ */
+template<>
+lengths replace<CORD>(benchmark::input& input)
+{
+    const size_t what = sizeof(pattern) - 1;
+    lengths result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        for (int k = 0; k < kinds; ++k)
+        {
+            CORD str = benchmark::cord(s, n);
+            const size_t with = strlen(replacements[k]);
+
+            for (size_t pos = CORD_str(str, 0, pattern); pos != CORD_NOT_FOUND; pos = CORD_str(str, pos + with, pattern))
+            {
+                str = CORD_cat(CORD_cat(CORD_substr(str, 0, pos), replacements[k]),
+                               CORD_substr(str, pos + what, CORD_len(str) - pos - what));
+            }
+
+            result.bytes[k] += CORD_len(str);
+        }
+    }
+
+    return result;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("replace")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "replace");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const lengths result = benchmark::run(input, threads, REPLACER);
+        timing.stop_(i_);
+        printf( "replace: %lu bytes grown, %lu shrunk, %lu same.\n", result.bytes[0], result.bytes[1], result.bytes[2]);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -4,6 +4,26 @@
 #include <algorithm>
 #include <cstring>
 
+/**
+ * The n characters of str from from.
+ */
+template<typename T>
+inline T substring(const T& str, size_t from, size_t n)
+{
+    return str.substr(from, n);
+}
+
+#if defined(USE_PMR_STRING_MONOTONIC) or defined(USE_PMR_STRING_POOL)
+/**
+ * std::pmr::string specialization, substr() would allocate from the default resource.
+ */
+template<>
+inline STR substring<STR>(const STR& str, size_t from, size_t n)
+{
+    return STR(str, from, n, benchmark::resources::local_());
+}
+#endif // USE_PMR_STRING_MONOTONIC or USE_PMR_STRING_POOL
+
 /**
  * Generic implementation.
  */
@@ -11,10 +31,12 @@ template<typename T>
 unsigned long slice(benchmark::input& input)
 {
     size_t total = 0, prev = 0, ante = 0;
+    input.preceding_(1, prev);
+    input.preceding_(2, ante);
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        T str(s);
+        T str(benchmark::make<T>(s, n));
 
         size_t cur = str.size();
         if (cur != 0)
@@ -27,7 +49,7 @@ unsigned long slice(benchmark::input& input)
                 std::swap(from, to);
             }
 
-            T sliced = str.substr(from, (to - from));
+            T sliced = substring(str, from, (to - from));
 
             total += sliced.size();
         }
@@ -47,9 +69,9 @@ unsigned long slice<PyStringObject>(benchmark::input& input)
 {
     size_t total = 0, prev = 0, ante = 0;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        PyObject *str = PyString_FromString(s);
+        PyObject *str = PyString_FromStringAndSize(s, n);
 
         size_t cur = PyString_Size(str);
         if (cur != 0)
@@ -116,9 +138,9 @@ unsigned long slice<SV>(benchmark::input& input)
 
     SV* const slice_args = newSV_type(SVt_PVLV);
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        SV* str = newSVpv(s, 0);
+        SV* str = newSVpvn(s, n);
 
         size_t cur = SvCUR(str);
         if (cur != 0)
@@ -158,9 +180,9 @@ unsigned long slice<CORD>(benchmark::input& input)
 {
     size_t total = 0, prev = 0, ante = 0;
 
-    BENCHMARK_FOREACH(s)
+    BENCHMARK_FOREACH_RECORD(s, n)
     {
-        CORD str = CORD_from_char_star(s);
+        CORD str = benchmark::cord(s, n);
 
         size_t cur = CORD_len(str);
         if (cur != 0)
@@ -185,14 +207,19 @@ unsigned long slice<CORD>(benchmark::input& input)
 }
 #endif // USE_GC_CORD
 
-int main(int argc, char* argv[])
+BENCHMARK_MAIN("slice")
 {
     BENCHMARK_INIT;
     BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
     BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "slice");
     BENCHMARK_ITERATE(input, iterations)
     {
-        printf( "slice: %lu bytes.\n", slice<STR>(input));
+        timing.start_();
+        const unsigned long bytes = benchmark::run(input, threads, slice<STR>);
+        timing.stop_(i_);
+        printf( "slice: %lu bytes.\n", bytes);
     }
     BENCHMARK_FINISH;
     return 0;
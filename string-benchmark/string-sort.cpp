@@ -0,0 +1,253 @@
+#include "config.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef USE_SORT_REFERENCE
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "reference"
+#endif // USE_SORT_REFERENCE
+
+/**
+ * Sorting.
+ *
+ * All the records are loaded into a vector, sorted, and checked by a sum
+ * of their lengths weighted by rank. This measures comparison, but also
+ * copy or swap costs, from reference counted to small string optimized.
+ * The sort-reference program sorts the mapped records themselves with
+ * a multikey quicksort, the best achievable as -nop is the lower bound.
+ * With --threads every shard is sorted separately.
+ */
+
+template<typename T>
+struct less
+{
+    inline bool operator()(const T& a, const T& b) const
+    {
+        return a < b;
+    }
+};
+
+#ifdef USE_GC_CORD
+template<>
+struct less<CORD>
+{
+    inline bool operator()(CORD a, CORD b) const
+    {
+        return CORD_cmp(a, b) < 0;
+    }
+};
+#endif // USE_GC_CORD
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+unsigned long sort(benchmark::input& input)
+{
+    std::vector<T> strings;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        strings.push_back(benchmark::make<T>(s, n));
+    }
+
+    std::sort(strings.begin(), strings.end(), less<T>());
+
+    unsigned long checksum = 0, rank = 0;
+    for (typename std::vector<T>::const_iterator str = strings.begin(); str != strings.end(); ++str)
+    {
+        checksum += ++rank * str->size();
+    }
+    return checksum;
+}
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, list.sort().
+ */
+template<>
+unsigned long sort<PyStringObject>(benchmark::input& input)
+{
+    PyObject* strings = PyList_New(0);
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        if (PyList_Append(strings, str) == -1)
+        {
+            exit(ENOMEM);
+        }
+        Py_DECREF(str);
+    }
+
+    if (PyList_Sort(strings) == -1)
+    {
+        exit(ECANCELED);
+    }
+
+    unsigned long checksum = 0;
+    for (Py_ssize_t i = 0, count = PyList_GET_SIZE(strings); i < count; ++i)
+    {
+        checksum += (i + 1) * PyString_GET_SIZE(PyList_GET_ITEM(strings, i));
+    }
+    Py_DECREF(strings);
+    return checksum;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization, sortsv() as in sort { $a cmp $b }.
+ */
+template<>
+unsigned long sort<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    AV* const strings = newAV();
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        av_push(strings, newSVpvn(s, n));
+    }
+
+    const SSize_t count = AvFILLp(strings) + 1;
+    sortsv(AvARRAY(strings), count, Perl_sv_cmp);
+
+    unsigned long checksum = 0;
+    for (SSize_t i = 0; i < count; ++i)
+    {
+        checksum += (i + 1) * SvCUR(AvARRAY(strings)[i]);
+    }
+    SvREFCNT_dec(strings);
+    return checksum;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization.
+ */
+template<>
+unsigned long sort<CORD>(benchmark::input& input)
+{
+    std::vector<CORD> strings;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        strings.push_back(benchmark::cord(s, n));
+    }
+
+    std::sort(strings.begin(), strings.end(), less<CORD>());
+
+    unsigned long checksum = 0, rank = 0;
+    for (std::vector<CORD>::const_iterator str = strings.begin(); str != strings.end(); ++str)
+    {
+        checksum += ++rank * CORD_len(*str);
+    }
+    return checksum;
+}
+#endif // USE_GC_CORD
+
+#ifdef USE_SORT_REFERENCE
+/**
+ * Byte at depth, the NUL that ends every record sorts first.
+ */
+inline int at(const std::pair<const char*, size_t>& r, size_t depth)
+{
+    return static_cast<unsigned char>(r.first[depth]);
+}
+
+/**
+ * Bentley and Sedgewick's multikey quicksort of records sharing their first depth bytes.
+ */
+static void multikey(std::pair<const char*, size_t>* a, size_t n, size_t depth)
+{
+    while (n > 16)
+    {
+        const int pivot = at(a[n / 2], depth);
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt)
+        {
+            const int c = at(a[i], depth);
+            if (c < pivot)
+            {
+                std::swap(a[lt++], a[i++]);
+            }
+            else if (c > pivot)
+            {
+                std::swap(a[i], a[--gt]);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        multikey(a, lt, depth);
+        if (pivot != 0)
+        {
+            multikey(a + lt, gt - lt, depth + 1);
+        }
+        a += gt;
+        n -= gt;
+    }
+
+    // Insertion sort of the few left.
+    for (size_t i = 1; i < n; ++i)
+    {
+        for (size_t j = i; j > 0 and strcmp(a[j - 1].first + depth, a[j].first + depth) > 0; --j)
+        {
+            std::swap(a[j - 1], a[j]);
+        }
+    }
+}
+
+/**
+ * The reference: no string type, the records stay where they are mapped.
+ */
+static unsigned long reference(benchmark::input& input)
+{
+    std::vector< std::pair<const char*, size_t> > records;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        records.push_back(std::make_pair(s, n));
+    }
+
+    if (records.begin() != records.end())
+    {
+        multikey(&records.front(), records.end() - records.begin(), 0);
+    }
+
+    unsigned long checksum = 0, rank = 0;
+    for (std::vector< std::pair<const char*, size_t> >::const_iterator r = records.begin(); r != records.end(); ++r)
+    {
+        checksum += ++rank * r->second;
+    }
+    return checksum;
+}
+#endif // USE_SORT_REFERENCE
+
+BENCHMARK_MAIN("sort")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "sort");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+#ifdef USE_SORT_REFERENCE
+        const unsigned long checksum = benchmark::run(input, threads, reference);
+#else // String type
+        const unsigned long checksum = benchmark::run(input, threads, sort<STR>);
+#endif // USE_SORT_REFERENCE
+        timing.stop_(i_);
+        printf( "sort: %lu checksum.\n", checksum);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include "config.hpp"
+
+/**
+ * Tokenizing.
+ *
+ * Every record is split on '/', the result is the number of components,
+ * empty ones included (one more than there are separators), and the sum
+ * of their lengths. Copying splitters allocate every component, the
+ * zero-copy ones share the record:
+ *
+ *  split-std-string                           find() and substr()
+ *  split-std-string-view                      the same over a std::string_view of the input
+ *  split-bstring                              bsplit()
+ *  split-bstring-bsplitcb                     bsplitcb(), a callback per component
+ *  split-bstring-list                         CBStringList::split()
+ *  split-yegorushkin-const-string             find() and substr()
+ *  split-yegorushkin-const-string-ref-substr  find() and ref_substr(), which shares the buffer
+ */
+
+#ifdef USE_SPLIT_VIEW
+#include <string_view>
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "std-string-view"
+#define SPLITTER split<std::string_view>
+#endif // USE_SPLIT_VIEW
+
+#ifdef USE_SPLIT_CALLBACK
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "bstring-bsplitcb"
+#define SPLITTER split_callback
+#endif // USE_SPLIT_CALLBACK
+
+#ifdef USE_SPLIT_LIST
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "bstring-list"
+#define SPLITTER split_list
+#endif // USE_SPLIT_LIST
+
+#ifdef USE_SPLIT_REF_SUBSTR
+#undef  BENCHMARK_IMPLEMENTATION
+#define BENCHMARK_IMPLEMENTATION "yegorushkin-const-string-ref-substr"
+#define SPLITTER split_ref_substr
+#endif // USE_SPLIT_REF_SUBSTR
+
+#ifndef SPLITTER
+#define SPLITTER split<STR>
+#endif // SPLITTER
+
+struct components
+{
+    unsigned long count;
+    unsigned long bytes;
+
+    components() : count(0), bytes(0)
+    {
+    }
+
+    inline components& operator+=(const components& other)
+    {
+        count += other.count;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+/**
+ * Position of the next separator from pos, or T::npos.
+ */
+template<typename T>
+inline size_t separator(const T& str, size_t pos)
+{
+    return str.find('/', pos);
+}
+
+#ifdef USE_CONST_STRING
+/**
+ * find(char) hands boost::cref() a temporary, which C++11 rejects.
+ */
+template<>
+inline size_t separator<STR>(const STR& str, size_t pos)
+{
+    static const char slash = '/';
+    return str.find(&slash, pos, 1);
+}
+#endif // USE_CONST_STRING
+
+/**
+ * Generic implementation.
+ */
+template<typename T>
+components split(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        T str(benchmark::make<T>(s, n));
+
+        for (size_t from = 0, to = 0; to != T::npos; from = to + 1)
+        {
+            to = separator(str, from);
+            T component = str.substr(from, (to == T::npos ? str.size() : to) - from);
+
+            ++result.count;
+            result.bytes += component.size();
+        }
+    }
+
+    return result;
+}
+
+#ifdef USE_SPLIT_REF_SUBSTR
+static components split_ref_substr(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        STR str(benchmark::make<STR>(s, n));
+
+        for (size_t from = 0, to = 0; to != STR::npos; from = to + 1)
+        {
+            to = separator(str, from);
+            STR component = str.ref_substr(from, (to == STR::npos ? str.size() : to) - from);
+
+            ++result.count;
+            result.bytes += component.size();
+        }
+    }
+
+    return result;
+}
+#endif // USE_SPLIT_REF_SUBSTR
+
+#if defined(USE_BSTRLIB) and not defined(USE_SPLIT_CALLBACK) and not defined(USE_SPLIT_LIST)
+/**
+ * Bstrlib specialization, bsplit(). Not in the variants, which would define it again in the driver.
+ */
+template<>
+components split<STR>(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        STR str(benchmark::make<STR>(s, n));
+
+        struct bstrList* const list = bsplit(&str, '/');
+        if (list == 0)
+        {
+            exit(ENOMEM);
+        }
+        result.count += list->qty;
+        for (int i = 0; i < list->qty; ++i)
+        {
+            result.bytes += list->entry[i]->slen;
+        }
+        bstrListDestroy(list);
+    }
+
+    return result;
+}
+#endif // USE_BSTRLIB, not a variant
+
+#ifdef USE_SPLIT_CALLBACK
+static int component(void* parm, int, int length)
+{
+    components& result = *static_cast<components*>(parm);
+    ++result.count;
+    result.bytes += length;
+    return 0;
+}
+
+static components split_callback(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        STR str(benchmark::make<STR>(s, n));
+
+        if (bsplitcb(&str, '/', 0, component, &result) != BSTR_OK)
+        {
+            exit(EINVAL);
+        }
+    }
+
+    return result;
+}
+#endif // USE_SPLIT_CALLBACK
+
+#ifdef USE_SPLIT_LIST
+static components split_list(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        STR str(benchmark::make<STR>(s, n));
+
+        Bstrlib::CBStringList list;
+        list.split(str, '/');
+        for (Bstrlib::CBStringList::const_iterator c = list.begin(); c != list.end(); ++c)
+        {
+            ++result.count;
+            result.bytes += c->slen;
+        }
+    }
+
+    return result;
+}
+#endif // USE_SPLIT_LIST
+
+#ifdef USE_QT4_STRING
+/**
+ * QString specialization, QString::split().
+ */
+template<>
+components split<QString>(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        const QStringList list = benchmark::make<QString>(s, n).split('/');
+        for (QStringList::const_iterator c = list.begin(); c != list.end(); ++c)
+        {
+            ++result.count;
+            result.bytes += c->size();
+        }
+    }
+
+    return result;
+}
+#endif // USE_QT4_STRING
+
+#ifdef USE_PYTHON_STRING
+/**
+ * Python String Object specialization, str.split('/').
+ */
+template<>
+components split<PyStringObject>(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        PyObject* str = PyString_FromStringAndSize(s, n);
+        PyObject* list = PyObject_CallMethod(str, const_cast<char*>("split"), const_cast<char*>("s"), "/");
+        if (list == NULL)
+        {
+            exit(ECANCELED);
+        }
+        for (Py_ssize_t i = 0, count = PyList_GET_SIZE(list); i < count; ++i)
+        {
+            ++result.count;
+            result.bytes += PyString_GET_SIZE(PyList_GET_ITEM(list, i));
+        }
+        Py_DECREF(list);
+        Py_DECREF(str);
+    }
+
+    return result;
+}
+#endif // USE_PYTHON_STRING
+
+#ifdef USE_PERL_STRING
+/**
+ * Perl scalar specialization.
+ * Emulates split '/', $str, -1 with a single character separator: a new scalar per field.
+ */
+template<>
+components split<SV>(benchmark::input& input)
+{
+    dTHX; /* fetch context */
+
+    components result;
+    AV* const fields = newAV();
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        SV* str = newSVpvn(s, n);
+
+        STRLEN length;
+        const char* from = SvPV_const(str, length);
+        const char* const end = from + length;
+        const char* to;
+        do
+        {
+            if ((to = static_cast<const char*>(memchr(from, '/', end - from))) == 0)
+            {
+                to = end;
+            }
+            av_push(fields, newSVpvn(from, to - from));
+            from = to + 1;
+        }
+        while (to != end);
+
+        for (SSize_t i = 0, count = AvFILLp(fields) + 1; i < count; ++i)
+        {
+            ++result.count;
+            result.bytes += SvCUR(AvARRAY(fields)[i]);
+        }
+        av_clear(fields);
+
+        SvREFCNT_dec(str);
+    }
+    SvREFCNT_dec(fields);
+
+    return result;
+}
+#endif // USE_PERL_STRING
+
+#ifdef USE_GC_CORD
+/**
+ * GC CORD specialization, CORD_chr() and CORD_substr().
+ */
+template<>
+components split<CORD>(benchmark::input& input)
+{
+    components result;
+
+    BENCHMARK_FOREACH_RECORD(s, n)
+    {
+        CORD str = benchmark::cord(s, n);
+
+        for (size_t from = 0, to = 0; to != CORD_NOT_FOUND; from = to + 1)
+        {
+            to = CORD_chr(str, from, '/');
+            CORD component = CORD_substr(str, from, (to == CORD_NOT_FOUND ? n : to) - from);
+
+            ++result.count;
+            result.bytes += CORD_len(component);
+        }
+    }
+
+    return result;
+}
+#endif // USE_GC_CORD
+
+BENCHMARK_MAIN("split")
+{
+    BENCHMARK_INIT;
+    BENCHMARK_GET_ITERATIONS(iterations);
+    BENCHMARK_GET_THREADS(threads);
+    BENCHMARK_ACQUIRE_INPUT(input);
+    BENCHMARK_GET_TIMING(timing, "split");
+    BENCHMARK_ITERATE(input, iterations)
+    {
+        timing.start_();
+        const components result = benchmark::run(input, threads, SPLITTER);
+        timing.stop_(i_);
+        printf( "split: %lu components, %lu bytes.\n", result.count, result.bytes);
+    }
+    BENCHMARK_FINISH;
+    return 0;
+}
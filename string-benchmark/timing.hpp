@@ -0,0 +1,188 @@
+/**
+ * In-process timing of every iteration.
+ *
+ * One JSON object per line is written to the --report=FILE option
+ * (stderr by default): an "index" line for the one-time input setup,
+ * with its mapping time and page faults,
+ * then an "iteration" line per measured BENCHMARK_ITERATE pass.
+ * Warm-up passes (--warmup=N) run first and are not reported.
+ * Iteration lines carry the resident set grown over the pass and, where the
+ * peak can be reset (Linux 4.0, /proc/self/clear_refs), the peak grown over
+ * it, in kilobytes: passes measure themselves, in the driver too.
+ * With --counters, iteration lines carry the counters.hpp events too,
+ * and implementations can add fields of their own: BENCHMARK_EXTRA_FIELDS
+ * names a function printing them (arena strings add the arena usage of the
+ * pass, see arena.hpp).
+ */
+#include <sys/resource.h>
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_RDTSC() __rdtsc()
+#else // No time stamp counter
+#define BENCHMARK_RDTSC() 0ULL
+#endif
+
+#ifndef BENCHMARK_EXTRA_FIELDS // see arena.hpp
+#define BENCHMARK_EXTRA_FIELDS 0
+#endif // BENCHMARK_EXTRA_FIELDS
+
+#define BENCHMARK_GET_TIMING(timing, name) benchmark::timing timing(argc, argv, name, input, BENCHMARK_EXTRA_FIELDS);
+
+namespace benchmark
+{
+
+inline long warmup(int argc, char* argv[])
+{
+    const char* const argv_ = option(argc, argv, "warmup");
+    if (not argv_)
+    {
+        return 0;
+    }
+    char* end;
+    const long count = strtol(argv_, &end, 10);
+    if (count < 0 or *end != '\0')
+    {
+        exit(EINVAL);
+    }
+    return count;
+}
+
+/**
+ * Nanoseconds on the raw monotonic clock, not slewed by NTP.
+ */
+inline unsigned long long nanoseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Resident set and its peak (VmRSS and VmHWM) in kilobytes, 0 without /proc.
+ */
+inline void resident(long& rss, long& peak)
+{
+    rss = peak = 0;
+    FILE* const status = fopen("/proc/self/status", "r");
+    if (status == 0)
+    {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), status))
+    {
+        sscanf(line, "VmRSS: %ld", &rss);
+        sscanf(line, "VmHWM: %ld", &peak);
+    }
+    fclose(status);
+}
+
+/**
+ * Restarts the peak resident set from the current one, false when it cannot.
+ */
+inline bool reset_peak()
+{
+    FILE* const clear_refs = fopen("/proc/self/clear_refs", "w");
+    return clear_refs and fputs("5", clear_refs) != EOF and fclose(clear_refs) == 0;
+}
+
+inline double seconds(const struct timeval& tv)
+{
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+class timing
+{
+public:
+    typedef void (*fields)(FILE* report);
+
+    timing(int argc, char* argv[], const char* const name, const input& data, fields extra)
+        : m_name(name), m_program(strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0]),
+          m_threads(threads(option(argc, argv, "threads"), true)), m_report(stderr), m_extra(extra), m_counters(argc, argv)
+    {
+        const char* const file_name = option(argc, argv, "report");
+        if (file_name and not (m_report = fopen(file_name, "a")))
+        {
+            exit(errno);
+        }
+
+        fprintf(m_report, "{\"benchmark\": \"%s\", \"program\": \"%s\", \"event\": \"index\", "
+                          "\"records\": %lu, \"bytes\": %lu, \"seconds\": %.9f, \"mapping\": %.9f, "
+                          "\"minor-faults\": %ld, \"major-faults\": %ld}\n",
+                m_name, m_program, data.records_(), data.bytes_(), data.indexing_(), data.mapping_(),
+                data.minor_faults_(), data.major_faults_());
+    }
+
+    inline void start_()
+    {
+        long peak;
+        m_peak_reset = reset_peak();
+        resident(m_rss, peak);
+        getrusage(RUSAGE_SELF, &m_usage);
+        m_counters.start_();
+        m_tsc = BENCHMARK_RDTSC();
+        m_start = nanoseconds();
+    }
+
+    /**
+     * Ends the pass started by start_(), warm-up passes have a negative iteration.
+     */
+    inline void stop_(long iteration)
+    {
+        const unsigned long long elapsed = nanoseconds() - m_start;
+        const unsigned long long tsc = BENCHMARK_RDTSC() - m_tsc;
+        m_counters.stop_();
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long rss, peak;
+        resident(rss, peak);
+
+        if (iteration >= 0)
+        {
+            fprintf(m_report, "{\"benchmark\": \"%s\", \"program\": \"%s\", \"event\": \"iteration\", "
+                              "\"iteration\": %ld, \"threads\": %ld, \"nanoseconds\": %llu, \"tsc\": %llu, "
+                              "\"user\": %.6f, \"system\": %.6f, \"minor-faults\": %ld, \"major-faults\": %ld, \"rss-grown\": %ld",
+                    m_name, m_program, iteration, m_threads, elapsed, tsc,
+                    seconds(usage.ru_utime) - seconds(m_usage.ru_utime),
+                    seconds(usage.ru_stime) - seconds(m_usage.ru_stime),
+                    usage.ru_minflt - m_usage.ru_minflt, usage.ru_majflt - m_usage.ru_majflt, rss - m_rss);
+            if (m_peak_reset)
+            {
+                fprintf(m_report, ", \"rss-peak-grown\": %ld", peak - m_rss);
+            }
+            m_counters.print_(m_report);
+            if (m_extra)
+            {
+                m_extra(m_report);
+            }
+            fputs("}\n", m_report);
+        }
+    }
+
+    ~timing()
+    {
+        if (m_report != stderr)
+        {
+            fclose(m_report);
+        }
+    }
+
+private:
+    timing(const timing&);
+    timing& operator=(const timing&);
+
+    const char* const m_name;
+    const char* const m_program;
+    const long m_threads;
+    FILE* m_report;
+    const fields m_extra; // of the translation unit, the driver links them all.
+    struct rusage m_usage;
+    long m_rss;
+    bool m_peak_reset;
+    unsigned long long m_tsc;
+    unsigned long long m_start;
+    counters m_counters;
+};
+
+} // benchmark namespace